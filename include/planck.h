@@ -39,6 +39,17 @@ typedef float complex  pk_complex;
 typedef double complex pk_complex_d;
 #endif
 
+/* Memory allocation */
+// every object and its sample storage is allocated through these hooks,
+// the returned pointer must be aligned to at least align bytes
+typedef void *(*pk_alloc_func)(size_t size, size_t align, void *ctx);
+typedef void (*pk_free_func)(void *ptr, void *ctx);
+
+// replace the global allocator, passing NULL hooks restores the default.
+// must be called before creating any objects, anything created earlier
+// would later be released through the new free hook.
+void pk_set_allocator(pk_alloc_func alloc, pk_free_func release, void *ctx);
+
 /* Mathematical functions */
 // solve for roots of a polynomial based on a Newton method by Kaj Madsen (1973).
 //
@@ -83,6 +94,7 @@ typedef struct pk_circ_ff_s pk_circ_ff;
 typedef struct pk_circ_cc_s pk_circ_cc;
 typedef struct pk_circ_uu_s pk_circ_uu;
 typedef struct pk_circ_ii_s pk_circ_ii;
+typedef struct pk_circ_qq_s pk_circ_qq;
 
 // float
 // creates a circular buffer
@@ -91,6 +103,13 @@ pk_circ_ff *pk_circ_ff_create(unsigned int size);
 // pushes a float onto the circular buffer
 void pk_circ_ff_push(pk_circ_ff *cb, float item);
 
+// pushes num floats onto the circular buffer at once
+void pk_circ_ff_append(pk_circ_ff *cb, const float *items, size_t num);
+
+// returns the window in place, oldest item first, without a copy
+// the pointer is valid for size items until the next push
+const float *pk_circ_ff_view(pk_circ_ff *cb);
+
 // reads the circular buffer up to some num items
 void pk_circ_ff_read(pk_circ_ff *cb, float *output, size_t num);
 
@@ -106,6 +125,8 @@ void pk_circ_ff_destroy(pk_circ_ff *cb);
 // pk_complex
 pk_circ_cc *pk_circ_cc_create(unsigned int size);
 void pk_circ_cc_push(pk_circ_cc *cb, pk_complex item);
+void pk_circ_cc_append(pk_circ_cc *cb, const pk_complex *items, size_t num);
+const pk_complex *pk_circ_cc_view(pk_circ_cc *cb);
 void pk_circ_cc_read(pk_circ_cc *cb, pk_complex *output, size_t num);
 pk_complex pk_circ_cc_pop(pk_circ_cc *cb);
 void pk_circ_cc_clear(pk_circ_cc *cb);
@@ -114,6 +135,8 @@ void pk_circ_cc_destroy(pk_circ_cc *cb);
 // unsigned characters
 pk_circ_uu *pk_circ_uu_create(unsigned int size);
 void pk_circ_uu_push(pk_circ_uu *cb, unsigned char item);
+void pk_circ_uu_append(pk_circ_uu *cb, const unsigned char *items, size_t num);
+const unsigned char *pk_circ_uu_view(pk_circ_uu *cb);
 void pk_circ_uu_read(pk_circ_uu *cb, unsigned char *output, size_t num);
 unsigned char pk_circ_uu_pop(pk_circ_uu *cb);
 void pk_circ_uu_clear(pk_circ_uu *cb);
@@ -122,17 +145,30 @@ void pk_circ_uu_destroy(pk_circ_uu *cb);
 // integers
 pk_circ_ii *pk_circ_ii_create(unsigned int size);
 void pk_circ_ii_push(pk_circ_ii *cb, int item);
+void pk_circ_ii_append(pk_circ_ii *cb, const int *items, size_t num);
+const int *pk_circ_ii_view(pk_circ_ii *cb);
 void pk_circ_ii_read(pk_circ_ii *cb, int *output, size_t num);
 int pk_circ_ii_pop(pk_circ_ii *cb);
 void pk_circ_ii_clear(pk_circ_ii *cb);
 void pk_circ_ii_destroy(pk_circ_ii *cb);
 
+// Q15 fixed point
+pk_circ_qq *pk_circ_qq_create(unsigned int size);
+void pk_circ_qq_push(pk_circ_qq *cb, int16_t item);
+void pk_circ_qq_append(pk_circ_qq *cb, const int16_t *items, size_t num);
+const int16_t *pk_circ_qq_view(pk_circ_qq *cb);
+void pk_circ_qq_read(pk_circ_qq *cb, int16_t *output, size_t num);
+int16_t pk_circ_qq_pop(pk_circ_qq *cb);
+void pk_circ_qq_clear(pk_circ_qq *cb);
+void pk_circ_qq_destroy(pk_circ_qq *cb);
+
 /* Resizable block of data */
 // forward declarations of the different block types
 typedef struct pk_block_ff_s pk_block_ff;
 typedef struct pk_block_cc_s pk_block_cc;
 typedef struct pk_block_uu_s pk_block_uu;
 typedef struct pk_block_ii_s pk_block_ii;
+typedef struct pk_block_qq_s pk_block_qq;
 
 // floats
 // create a block of data
@@ -141,12 +177,23 @@ pk_block_ff *pk_block_ff_create(size_t size);
 // resize a block of data
 void pk_block_ff_resize(pk_block_ff *b, size_t new_size);
 
+// make room for at least size items, growing geometrically
+void pk_block_ff_reserve(pk_block_ff *b, size_t size);
+
 // return a pointer to the block of data
 float *pk_block_ff_ptr(pk_block_ff *b);
 
 // push an item onto the block
 void pk_block_ff_push(pk_block_ff *b, float item);
 
+// push num items onto the block at once
+void pk_block_ff_append(pk_block_ff *b, const float *items, size_t num);
+
+// return a pointer to the end of the block with room for num items,
+// write directly into it and then commit the number of items written
+float *pk_block_ff_begin_write(pk_block_ff *b, size_t num);
+void pk_block_ff_commit(pk_block_ff *b, size_t num);
+
 // return the number of items in this pk_block
 size_t pk_block_ff_nitems(pk_block_ff *b);
 
@@ -163,7 +210,11 @@ void pk_block_ff_destroy(pk_block_ff *b);
 pk_block_cc *pk_block_cc_create(size_t size);
 void pk_block_cc_resize(pk_block_cc *b, size_t new_size);
 pk_complex *pk_block_cc_ptr(pk_block_cc *b);
+void pk_block_cc_reserve(pk_block_cc *b, size_t size);
 void pk_block_cc_push(pk_block_cc *b, pk_complex item);
+void pk_block_cc_append(pk_block_cc *b, const pk_complex *items, size_t num);
+pk_complex *pk_block_cc_begin_write(pk_block_cc *b, size_t num);
+void pk_block_cc_commit(pk_block_cc *b, size_t num);
 size_t pk_block_cc_nitems(pk_block_cc *b);
 size_t pk_block_cc_size(pk_block_cc *b);
 void pk_block_cc_clear(pk_block_cc *b);
@@ -173,7 +224,11 @@ void pk_block_cc_destroy(pk_block_cc *b);
 pk_block_uu *pk_block_uu_create(size_t size);
 void pk_block_uu_resize(pk_block_uu *b, size_t new_size);
 unsigned char *pk_block_uu_ptr(pk_block_uu *b);
+void pk_block_uu_reserve(pk_block_uu *b, size_t size);
 void pk_block_uu_push(pk_block_uu *b, unsigned char item);
+void pk_block_uu_append(pk_block_uu *b, const unsigned char *items, size_t num);
+unsigned char *pk_block_uu_begin_write(pk_block_uu *b, size_t num);
+void pk_block_uu_commit(pk_block_uu *b, size_t num);
 size_t pk_block_uu_nitems(pk_block_uu *b);
 size_t pk_block_uu_size(pk_block_uu *b);
 void pk_block_uu_clear(pk_block_uu *b);
@@ -183,27 +238,52 @@ void pk_block_uu_destroy(pk_block_uu *b);
 pk_block_ii *pk_block_ii_create(size_t size);
 void pk_block_ii_resize(pk_block_ii *b, size_t new_size);
 int *pk_block_ii_ptr(pk_block_ii *b);
+void pk_block_ii_reserve(pk_block_ii *b, size_t size);
 void pk_block_ii_push(pk_block_ii *b, int item);
+void pk_block_ii_append(pk_block_ii *b, const int *items, size_t num);
+int *pk_block_ii_begin_write(pk_block_ii *b, size_t num);
+void pk_block_ii_commit(pk_block_ii *b, size_t num);
 size_t pk_block_ii_nitems(pk_block_ii *b);
 size_t pk_block_ii_size(pk_block_ii *b);
 void pk_block_ii_clear(pk_block_ii *b);
 void pk_block_ii_destroy(pk_block_ii *b);
 
-
-/* Simple FIFO queue based on a linked list */
+// Q15 fixed point
+pk_block_qq *pk_block_qq_create(size_t size);
+void pk_block_qq_resize(pk_block_qq *b, size_t new_size);
+int16_t *pk_block_qq_ptr(pk_block_qq *b);
+void pk_block_qq_reserve(pk_block_qq *b, size_t size);
+void pk_block_qq_push(pk_block_qq *b, int16_t item);
+void pk_block_qq_append(pk_block_qq *b, const int16_t *items, size_t num);
+int16_t *pk_block_qq_begin_write(pk_block_qq *b, size_t num);
+void pk_block_qq_commit(pk_block_qq *b, size_t num);
+size_t pk_block_qq_nitems(pk_block_qq *b);
+size_t pk_block_qq_size(pk_block_qq *b);
+void pk_block_qq_clear(pk_block_qq *b);
+void pk_block_qq_destroy(pk_block_qq *b);
+
+
+/* Simple FIFO queue based on a growable ring array */
 // forward declarations of queue objects
 typedef struct pk_queue_ff_s pk_queue_ff;
 typedef struct pk_queue_cc_s pk_queue_cc;
 typedef struct pk_queue_uu_s pk_queue_uu;
 typedef struct pk_queue_ii_s pk_queue_ii;
+typedef struct pk_queue_qq_s pk_queue_qq;
 
 // float
-// creates a FIFO queue that utilizes a linked list
+// creates a FIFO queue that grows as needed
 pk_queue_ff *pk_queue_ff_create();
 
+// make room for at least size items without further allocations
+void pk_queue_ff_reserve(pk_queue_ff *q, size_t size);
+
 // insert an item into the queue
 void pk_queue_ff_insert(pk_queue_ff *q, float item);
 
+// insert num items into the queue at once
+void pk_queue_ff_append(pk_queue_ff *q, const float *items, size_t num);
+
 // dequeue a single item at the beginning of the list
 void pk_queue_ff_dequeue(pk_queue_ff *q);
 
@@ -222,7 +302,9 @@ void pk_queue_ff_destroy(pk_queue_ff *q);
 
 // pk_complex
 pk_queue_cc *pk_queue_cc_create();
+void pk_queue_cc_reserve(pk_queue_cc *q, size_t size);
 void pk_queue_cc_insert(pk_queue_cc *q, pk_complex item);
+void pk_queue_cc_append(pk_queue_cc *q, const pk_complex *items, size_t num);
 void pk_queue_cc_dequeue(pk_queue_cc *q);
 void pk_queue_cc_clear(pk_queue_cc *q);
 size_t pk_queue_cc_nitems(pk_queue_cc *q);
@@ -231,7 +313,9 @@ void pk_queue_cc_destroy(pk_queue_cc *q);
 
 // unsigned char
 pk_queue_uu *pk_queue_uu_create();
+void pk_queue_uu_reserve(pk_queue_uu *q, size_t size);
 void pk_queue_uu_insert(pk_queue_uu *q, unsigned char item);
+void pk_queue_uu_append(pk_queue_uu *q, const unsigned char *items, size_t num);
 void pk_queue_uu_dequeue(pk_queue_uu *q);
 void pk_queue_uu_clear(pk_queue_uu *q);
 size_t pk_queue_uu_nitems(pk_queue_uu *q);
@@ -240,18 +324,103 @@ void pk_queue_uu_destroy(pk_queue_uu *q);
 
 // integer
 pk_queue_ii *pk_queue_ii_create();
+void pk_queue_ii_reserve(pk_queue_ii *q, size_t size);
 void pk_queue_ii_insert(pk_queue_ii *q, int item);
+void pk_queue_ii_append(pk_queue_ii *q, const int *items, size_t num);
 void pk_queue_ii_dequeue(pk_queue_ii *q);
 void pk_queue_ii_clear(pk_queue_ii *q);
 size_t pk_queue_ii_nitems(pk_queue_ii *q);
 void pk_queue_ii_read(pk_queue_ii *q, int *output, size_t num);
 void pk_queue_ii_destroy(pk_queue_ii *q);
 
+// Q15 fixed point
+pk_queue_qq *pk_queue_qq_create();
+void pk_queue_qq_reserve(pk_queue_qq *q, size_t size);
+void pk_queue_qq_insert(pk_queue_qq *q, int16_t item);
+void pk_queue_qq_append(pk_queue_qq *q, const int16_t *items, size_t num);
+void pk_queue_qq_dequeue(pk_queue_qq *q);
+void pk_queue_qq_clear(pk_queue_qq *q);
+size_t pk_queue_qq_nitems(pk_queue_qq *q);
+void pk_queue_qq_read(pk_queue_qq *q, int16_t *output, size_t num);
+void pk_queue_qq_destroy(pk_queue_qq *q);
+
+
+/* Lock-free single-producer/single-consumer ring buffer */
+// safe for handing samples from one thread to another
+// as long as only one thread writes and only one reads
+//
+// forward declarations of the ring buffer objects
+typedef struct pk_ring_ff_s pk_ring_ff;
+typedef struct pk_ring_cc_s pk_ring_cc;
+typedef struct pk_ring_uu_s pk_ring_uu;
+typedef struct pk_ring_ii_s pk_ring_ii;
+typedef struct pk_ring_qq_s pk_ring_qq;
+
+// float
+// creates a ring buffer holding at least size items,
+// the capacity is rounded up to a power of 2
+pk_ring_ff *pk_ring_ff_create(size_t size);
+
+// producer: write up to num items, returns the number written
+size_t pk_ring_ff_write(pk_ring_ff *r, const float *input, size_t num);
+
+// consumer: read up to num items, returns the number read
+size_t pk_ring_ff_read(pk_ring_ff *r, float *output, size_t num);
+
+// return the number of items ready to be read
+size_t pk_ring_ff_nitems(pk_ring_ff *r);
+
+// return the number of items that can be written
+size_t pk_ring_ff_space(pk_ring_ff *r);
+
+// return the capacity of the ring buffer
+size_t pk_ring_ff_size(pk_ring_ff *r);
+
+// destroy the ring buffer object
+void pk_ring_ff_destroy(pk_ring_ff *r);
+
+// pk_complex
+pk_ring_cc *pk_ring_cc_create(size_t size);
+size_t pk_ring_cc_write(pk_ring_cc *r, const pk_complex *input, size_t num);
+size_t pk_ring_cc_read(pk_ring_cc *r, pk_complex *output, size_t num);
+size_t pk_ring_cc_nitems(pk_ring_cc *r);
+size_t pk_ring_cc_space(pk_ring_cc *r);
+size_t pk_ring_cc_size(pk_ring_cc *r);
+void pk_ring_cc_destroy(pk_ring_cc *r);
+
+// unsigned char
+pk_ring_uu *pk_ring_uu_create(size_t size);
+size_t pk_ring_uu_write(pk_ring_uu *r, const unsigned char *input, size_t num);
+size_t pk_ring_uu_read(pk_ring_uu *r, unsigned char *output, size_t num);
+size_t pk_ring_uu_nitems(pk_ring_uu *r);
+size_t pk_ring_uu_space(pk_ring_uu *r);
+size_t pk_ring_uu_size(pk_ring_uu *r);
+void pk_ring_uu_destroy(pk_ring_uu *r);
+
+// integer
+pk_ring_ii *pk_ring_ii_create(size_t size);
+size_t pk_ring_ii_write(pk_ring_ii *r, const int *input, size_t num);
+size_t pk_ring_ii_read(pk_ring_ii *r, int *output, size_t num);
+size_t pk_ring_ii_nitems(pk_ring_ii *r);
+size_t pk_ring_ii_space(pk_ring_ii *r);
+size_t pk_ring_ii_size(pk_ring_ii *r);
+void pk_ring_ii_destroy(pk_ring_ii *r);
+
+// Q15 fixed point
+pk_ring_qq *pk_ring_qq_create(size_t size);
+size_t pk_ring_qq_write(pk_ring_qq *r, const int16_t *input, size_t num);
+size_t pk_ring_qq_read(pk_ring_qq *r, int16_t *output, size_t num);
+size_t pk_ring_qq_nitems(pk_ring_qq *r);
+size_t pk_ring_qq_space(pk_ring_qq *r);
+size_t pk_ring_qq_size(pk_ring_qq *r);
+void pk_ring_qq_destroy(pk_ring_qq *r);
+
 
 /* Dot product object */
 // forward declarations of dot product objects
 typedef struct pk_dotprod_ff_s pk_dotprod_ff;
 typedef struct pk_dotprod_ii_s pk_dotprod_ii;
+typedef struct pk_dotprod_qq_s pk_dotprod_qq;
 typedef struct pk_dotprod_uu_s pk_dotprod_uu;
 typedef struct pk_dotprod_cc_s pk_dotprod_cc;
 
@@ -259,25 +428,139 @@ typedef struct pk_dotprod_cc_s pk_dotprod_cc;
 // creates a dot product object that holds a sequence of coefficients
 pk_dotprod_ff *pk_dotprod_ff_create(const float *seq, size_t size);
 
+// load a new sequence of coefficients
+void pk_dotprod_ff_load(pk_dotprod_ff *dp, const float *seq, size_t size);
+
 // executes a dot product against an incoming sequence of coefficients
+// uses vector instructions when the cpu supports them
 float pk_dotprod_ff_execute(pk_dotprod_ff *dp, const float *input, size_t size);
 
 // destroys a dot product object
 void pk_dotprod_ff_destroy(pk_dotprod_ff *dp);
 
 pk_dotprod_ii *pk_dotprod_ii_create(const int *seq, size_t size);
+void pk_dotprod_ii_load(pk_dotprod_ii *dp, const int *seq, size_t size);
 int pk_dotprod_ii_execute(pk_dotprod_ii *dp, const int *input, size_t size);
 void pk_dotprod_ii_destroy(pk_dotprod_ii *dp);
 
+// Q15 fixed point, rounded and saturated
+pk_dotprod_qq *pk_dotprod_qq_create(const int16_t *seq, size_t size);
+void pk_dotprod_qq_load(pk_dotprod_qq *dp, const int16_t *seq, size_t size);
+int16_t pk_dotprod_qq_execute(pk_dotprod_qq *dp, const int16_t *input, size_t size);
+void pk_dotprod_qq_destroy(pk_dotprod_qq *dp);
+
 pk_dotprod_uu *pk_dotprod_uu_create(const unsigned char *seq, size_t size);
+void pk_dotprod_uu_load(pk_dotprod_uu *dp, const unsigned char *seq, size_t size);
 unsigned char pk_dotprod_uu_execute(pk_dotprod_uu *dp, const unsigned char *input, size_t size);
 void pk_dotprod_uu_destroy(pk_dotprod_uu *dp);
 
 pk_dotprod_cc *pk_dotprod_cc_create(const pk_complex *seq, size_t size);
+void pk_dotprod_cc_load(pk_dotprod_cc *dp, const pk_complex *seq, size_t size);
 pk_complex pk_dotprod_cc_execute(pk_dotprod_cc *dp, const pk_complex *input, size_t size);
 void pk_dotprod_cc_destroy(pk_dotprod_cc *dp);
 
 
+/* Numerically controlled oscillator */
+// forward declaration of the oscillator
+typedef struct pk_nco_s pk_nco;
+
+// create an oscillator at freq radians per sample using a
+// fixed point phase accumulator and a sine lookup table.
+// a non-zero interp linearly interpolates between table entries
+pk_nco *pk_nco_create(float freq, int interp);
+
+// set or nudge the frequency in radians per sample
+void pk_nco_set_frequency(pk_nco *nco, float freq);
+void pk_nco_adjust_frequency(pk_nco *nco, float dfreq);
+
+// set or nudge the phase in radians
+void pk_nco_set_phase(pk_nco *nco, float phase);
+void pk_nco_adjust_phase(pk_nco *nco, float dphase);
+
+// read back the frequency and phase in radians
+float pk_nco_get_frequency(pk_nco *nco);
+float pk_nco_get_phase(pk_nco *nco);
+
+// generate num samples of e^{j phase}, stepping the phase after each
+void pk_nco_generate(pk_nco *nco, pk_complex *output, size_t num);
+
+// multiply the input by e^{j phase} or e^{-j phase}
+void pk_nco_mix_up(pk_nco *nco, pk_complex *output, const pk_complex *input, size_t num);
+void pk_nco_mix_down(pk_nco *nco, pk_complex *output, const pk_complex *input, size_t num);
+
+// destroy the oscillator
+void pk_nco_destroy(pk_nco *nco);
+
+
+/* Symbol timing recovery */
+// timing error detectors, Gardner works on two interpolants per symbol
+// and is carrier independent, Mueller-Muller is decision directed and
+// uses one interpolant per symbol
+typedef enum
+{
+    PK_SYMSYNC_GARDNER,
+    PK_SYMSYNC_MM
+} pk_symsync_ted;
+
+// forward declaration of the timing recovery object
+typedef struct pk_symsync_s pk_symsync;
+
+// create a timing recovery loop for sps >= 2 samples per symbol,
+// bandwidth is the normalized loop bandwidth per symbol (e.g. 0.01)
+pk_symsync *pk_symsync_create(float sps, pk_symsync_ted ted, float bandwidth);
+
+// change the loop bandwidth while running
+void pk_symsync_set_bandwidth(pk_symsync *ss, float bandwidth);
+
+// clear the interpolator history and loop state
+void pk_symsync_reset(pk_symsync *ss);
+
+// consume num samples and write out the recovered symbols,
+// output needs room for num symbols. returns the symbols written
+size_t pk_symsync_execute(
+    pk_symsync *ss,
+    pk_complex *output,
+    const pk_complex *input,
+    size_t num
+);
+
+// the same for a real baseband signal, such as a frequency
+// discriminator output, without widening it to complex first
+size_t pk_symsync_execute_real(
+    pk_symsync *ss,
+    float *output,
+    const float *input,
+    size_t num
+);
+
+// destroy the timing recovery object
+void pk_symsync_destroy(pk_symsync *ss);
+
+
+/* Costas carrier recovery */
+// forward declaration of the decision directed QPSK carrier loop
+typedef struct pk_costas_s pk_costas;
+
+// create a carrier loop updated once every samp_sym samples,
+// bandwidth is the normalized loop bandwidth per symbol
+pk_costas *pk_costas_create(float samp_sym, float bandwidth);
+
+// change the loop bandwidth while running
+void pk_costas_set_bandwidth(pk_costas *cl, float bandwidth);
+
+// remove the current carrier estimate from num samples
+void pk_costas_mix(pk_costas *cl, pk_complex *output, const pk_complex *input, size_t num);
+
+// feed back a symbol built from mixed samples, returns the phase error
+float pk_costas_update(pk_costas *cl, pk_complex symbol);
+
+// carrier frequency estimate in radians per sample
+float pk_costas_get_frequency(pk_costas *cl);
+
+// destroy the carrier loop
+void pk_costas_destroy(pk_costas *cl);
+
+
 /* Modems */
 /* AFSK modulator */
 // forward declarations declarations of the FSK modem
@@ -320,7 +603,8 @@ pk_bfskdemod *pk_bfskdemod_create(
 // execute on a symbol
 unsigned char pk_bfskdemod_execute(pk_bfskdemod *fd, const pk_complex *samples);
 
-// process a batch of samples
+// process a batch of samples, the correlators slide
+// by one sample at a constant cost per input sample
 // warning: clears output buffer upon execution
 void pk_bfskdemod_process(
     pk_bfskdemod *fd,
@@ -332,9 +616,42 @@ void pk_bfskdemod_process(
 // and reads out the number of bits decoded
 unsigned char *pk_bfskdemod_read(pk_bfskdemod *fd, size_t *nitems);
 
+// enable (non-zero) or disable the soft decision output, off by default
+void pk_bfskdemod_set_soft(pk_bfskdemod *fd, int enable);
+
+// return a pointer to one soft value per decoded bit of the last batch.
+// each lies in -1..1, +1 a confident one and -1 a confident zero; the
+// magnitude is the smaller of the two symbols' mark minus space energy
+// over their sum. 127.5f * (1 + soft) rounds to a Viterbi soft symbol.
+// returns NULL when the soft output is disabled
+float *pk_bfskdemod_read_soft(pk_bfskdemod *fd, size_t *nitems);
+
 // destroy the FSK demodulator
 void pk_bfskdemod_destroy(pk_bfskdemod *fd);
 
+/* Q15 AFSK demodulator */
+// fixed point BFSK demodulator for real 16-bit input such as audio,
+// decisions are made the same way as the float demodulator
+typedef struct pk_bfskdemod_qq_s pk_bfskdemod_qq;
+
+pk_bfskdemod_qq *pk_bfskdemod_qq_create(
+    unsigned int samp_sym,   // samples per symbol
+    unsigned int baud,       // baud rate
+    float mark_freq,         // mark frequency  (1)
+    float space_freq         // space frequency (0)
+);
+
+// process a batch of Q15 samples
+// warning: clears output buffer upon execution
+void pk_bfskdemod_qq_process(
+    pk_bfskdemod_qq *fd,
+    const int16_t *input,
+    size_t num
+);
+
+unsigned char *pk_bfskdemod_qq_read(pk_bfskdemod_qq *fd, size_t *nitems);
+void pk_bfskdemod_qq_destroy(pk_bfskdemod_qq *fd);
+
 /* FSK9600 modulator */
 // create an FSK modulator
 pk_fsk96mod *pk_fsk96mod_create(
@@ -364,7 +681,7 @@ pk_fsk96demod *pk_fsk96demod_create(
 // execute on a symbol
 unsigned char pk_fsk96demod_execute(pk_fsk96demod *fd, const float *samples);
 
-// process a batch of samples
+// process a batch of samples using a moving sum
 // warning: clears output buffer upon execution
 void pk_fsk96demod_process(
     pk_fsk96demod *fd,
@@ -376,38 +693,112 @@ void pk_fsk96demod_process(
 // and reads out the number of bits decoded
 unsigned char *pk_fsk96demod_read(pk_fsk96demod *fd, size_t *nitems);
 
+// enable or disable the soft decision output, the soft values lie in
+// -1..1 as for the BFSK demodulator, built from the integrator outputs
+// normalized by the symbol energy
+void pk_fsk96demod_set_soft(pk_fsk96demod *fd, int enable);
+float *pk_fsk96demod_read_soft(pk_fsk96demod *fd, size_t *nitems);
+
 // destroy the FSK demodulator
 void pk_fsk96demod_destroy(pk_fsk96demod *fd);
 
 
-/* Quadrature modulator */
-// TODO
-// forward declarations for the quadrature modulator
+/* Staggered Quadrature Phase-shift Keying (OQPSK) modulator */
+// forward declarations for the QPSK/OQPSK modem
+typedef struct pk_oqpsk_mod_s pk_oqpsk_mod;
+typedef struct pk_oqpsk_demod_s pk_oqpsk_demod;
 
+// create a rectangular pulse modulator with an even number of samples
+// per symbol. a non-zero offset delays the quadrature arm by half a
+// symbol (OQPSK), otherwise both arms switch together (QPSK)
+pk_oqpsk_mod *pk_oqpsk_mod_create(unsigned int samp_sym, int offset);
 
-/* Quadrature demodulator */
-// TODO
-// forward declarations for the quadrature demodulator
+// execute on two bits, in-phase first, and produce samp_sym samples
+void pk_oqpsk_mod_execute(pk_oqpsk_mod *fm, pk_complex *sym, const unsigned char *bits);
 
+// process a batch of num bits (even), producing num / 2 symbols
+void pk_oqpsk_mod_process(
+    pk_oqpsk_mod *fm,
+    pk_complex *output,
+    const unsigned char *input,
+    size_t num
+);
 
-/* Staggered Quadrature Phase-shift Keying (OQPSK) modulator */
-// TODO
-// forward declarations for the OQPSK modulator
+// destroy the modulator
+void pk_oqpsk_mod_destroy(pk_oqpsk_mod *fm);
 
 
 /* Staggered Quadrature Phase-shift Keying (OQPSK) demodulator */
-// TODO
-// forward declarations for the OQPSK demodulator
+// create a matched filter demodulator with a Costas carrier loop and
+// Gardner symbol timing recovery, bandwidth is the normalized bandwidth
+// per symbol of both loops (e.g. 0.02). the carrier loop locks with the
+// usual four fold phase ambiguity, which can swap or invert the arms
+pk_oqpsk_demod *pk_oqpsk_demod_create(unsigned int samp_sym, int offset, float bandwidth);
+
+// process a batch of samples
+// warning: clears output buffer upon execution
+void pk_oqpsk_demod_process(
+    pk_oqpsk_demod *fd,
+    const pk_complex *input,
+    size_t num
+);
+
+// return a pointer to the decoded bits, two per symbol
+unsigned char *pk_oqpsk_demod_read(pk_oqpsk_demod *fd, size_t *nitems);
+
+// carrier frequency estimate in radians per sample
+float pk_oqpsk_demod_get_frequency(pk_oqpsk_demod *fd);
+
+// destroy the demodulator
+void pk_oqpsk_demod_destroy(pk_oqpsk_demod *fd);
 
 
 /* Gaussian Minimum-shift Keying (GMSK) modulator */
-// TODO
-// forward declarations for the GMSK modulator
+// forward declarations for the GMSK modem
+typedef struct pk_gmskmod_s pk_gmskmod;
+typedef struct pk_gmskdemod_s pk_gmskdemod;
+
+// create a GMSK modulator, a one bit shifts the frequency up
+pk_gmskmod *pk_gmskmod_create(
+    unsigned int samp_sym,   // samples per symbol
+    float bt,                // bandwidth-time product (e.g. 0.5)
+    unsigned int span        // Gaussian pulse length in symbols (1 to 8)
+);
+
+// execute on a bit and produce samp_sym samples
+void pk_gmskmod_execute(pk_gmskmod *fm, pk_complex *sym, unsigned char bit);
+
+// process a batch of bits
+void pk_gmskmod_process(
+    pk_gmskmod *fm,
+    pk_complex *output,
+    const unsigned char *input,
+    size_t num
+);
+
+// destroy the GMSK modulator
+void pk_gmskmod_destroy(pk_gmskmod *fm);
 
 
 /* Gaussian Minimum-shift Keying (GMSK) demodulator */
-// TODO
-// forward declarations for the GMSK demodulator
+// create a GMSK demodulator for samp_sym >= 2 samples per symbol,
+// bandwidth is the normalized timing loop bandwidth (e.g. 0.01)
+pk_gmskdemod *pk_gmskdemod_create(unsigned int samp_sym, float bandwidth);
+
+// process a batch of samples
+// warning: clears output buffer upon execution
+void pk_gmskdemod_process(
+    pk_gmskdemod *fd,
+    const pk_complex *input,
+    size_t num
+);
+
+// return a pointer to the output block of data
+// and reads out the number of bits decoded
+unsigned char *pk_gmskdemod_read(pk_gmskdemod *fd, size_t *nitems);
+
+// destroy the GMSK demodulator
+void pk_gmskdemod_destroy(pk_gmskdemod *fd);
 
 
 /* Filter objects */
@@ -416,6 +807,7 @@ void pk_fsk96demod_destroy(pk_fsk96demod *fd);
 // forward declarations of the FIR filter
 typedef struct pk_fir_ff_s pk_fir_ff;
 typedef struct pk_fir_cc_s pk_fir_cc;
+typedef struct pk_fir_qq_s pk_fir_qq;
 
 // float
 // create a FIR filter structure
@@ -436,6 +828,113 @@ void pk_fir_cc_load(pk_fir_cc *fir, const pk_complex *coeff);
 void pk_fir_cc_execute(pk_fir_cc *fir, pk_complex *output, const pk_complex *samples, size_t size);
 void pk_fir_cc_destroy(pk_fir_cc *fir);
 
+// Q15 fixed point
+pk_fir_qq *pk_fir_qq_create(unsigned int order, const int16_t *coeff);
+void pk_fir_qq_load(pk_fir_qq *fir, const int16_t *coeff);
+void pk_fir_qq_execute(pk_fir_qq *fir, int16_t *output, const int16_t *samples, size_t size);
+void pk_fir_qq_destroy(pk_fir_qq *fir);
+
+
+/* Decimating FIR filter */
+// forward declarations of the decimating filter
+typedef struct pk_firdecim_ff_s pk_firdecim_ff;
+typedef struct pk_firdecim_cc_s pk_firdecim_cc;
+typedef struct pk_firdecim_qq_s pk_firdecim_qq;
+
+// float
+// create a filter that keeps one output every factor input samples
+pk_firdecim_ff *pk_firdecim_ff_create(unsigned int factor, unsigned int order, const float *coeff);
+
+// load the decimator with new coefficients
+void pk_firdecim_ff_load(pk_firdecim_ff *d, const float *coeff);
+
+// execute the decimator over some set of samples
+// returns the number of outputs written
+size_t pk_firdecim_ff_execute(pk_firdecim_ff *d, float *output, const float *samples, size_t size);
+
+// destroy the decimator object
+void pk_firdecim_ff_destroy(pk_firdecim_ff *d);
+
+// pk_complex
+pk_firdecim_cc *pk_firdecim_cc_create(unsigned int factor, unsigned int order, const pk_complex *coeff);
+void pk_firdecim_cc_load(pk_firdecim_cc *d, const pk_complex *coeff);
+size_t pk_firdecim_cc_execute(pk_firdecim_cc *d, pk_complex *output, const pk_complex *samples, size_t size);
+void pk_firdecim_cc_destroy(pk_firdecim_cc *d);
+
+// Q15 fixed point
+pk_firdecim_qq *pk_firdecim_qq_create(unsigned int factor, unsigned int order, const int16_t *coeff);
+void pk_firdecim_qq_load(pk_firdecim_qq *d, const int16_t *coeff);
+size_t pk_firdecim_qq_execute(pk_firdecim_qq *d, int16_t *output, const int16_t *samples, size_t size);
+void pk_firdecim_qq_destroy(pk_firdecim_qq *d);
+
+
+/* Polyphase interpolating FIR filter */
+// forward declarations of the interpolating filter
+typedef struct pk_firinterp_ff_s pk_firinterp_ff;
+typedef struct pk_firinterp_cc_s pk_firinterp_cc;
+typedef struct pk_firinterp_qq_s pk_firinterp_qq;
+
+// float
+// create a filter that outputs factor samples for every input sample
+pk_firinterp_ff *pk_firinterp_ff_create(unsigned int factor, unsigned int order, const float *coeff);
+
+// load the interpolator with new coefficients
+void pk_firinterp_ff_load(pk_firinterp_ff *f, const float *coeff);
+
+// execute the interpolator, output must hold factor * size items
+void pk_firinterp_ff_execute(pk_firinterp_ff *f, float *output, const float *samples, size_t size);
+
+// destroy the interpolator object
+void pk_firinterp_ff_destroy(pk_firinterp_ff *f);
+
+// pk_complex
+pk_firinterp_cc *pk_firinterp_cc_create(unsigned int factor, unsigned int order, const pk_complex *coeff);
+void pk_firinterp_cc_load(pk_firinterp_cc *f, const pk_complex *coeff);
+void pk_firinterp_cc_execute(pk_firinterp_cc *f, pk_complex *output, const pk_complex *samples, size_t size);
+void pk_firinterp_cc_destroy(pk_firinterp_cc *f);
+
+// Q15 fixed point
+pk_firinterp_qq *pk_firinterp_qq_create(unsigned int factor, unsigned int order, const int16_t *coeff);
+void pk_firinterp_qq_load(pk_firinterp_qq *f, const int16_t *coeff);
+void pk_firinterp_qq_execute(pk_firinterp_qq *f, int16_t *output, const int16_t *samples, size_t size);
+void pk_firinterp_qq_destroy(pk_firinterp_qq *f);
+
+
+/* FFT fast convolution filter */
+// overlap-save FIR filter for long filters, produces the same output
+// as the direct form FIR delayed by pk_fftfilt_XX_delay samples
+//
+// forward declarations of the FFT filter
+typedef struct pk_fftfilt_ff_s pk_fftfilt_ff;
+typedef struct pk_fftfilt_cc_s pk_fftfilt_cc;
+
+// float
+// create an FFT filter structure with an even transform size nfft
+// above order, each transform filters nfft - order new samples. zero
+// picks a power of two at least four times the filter length, smaller
+// transforms trade throughput for less delay
+pk_fftfilt_ff *pk_fftfilt_ff_create(unsigned int order, unsigned int nfft, const float *coeff);
+
+// load the FFT filter with new coefficients
+void pk_fftfilt_ff_load(pk_fftfilt_ff *f, const float *coeff);
+
+// execute the FFT filter over any number of samples
+void pk_fftfilt_ff_execute(pk_fftfilt_ff *f, float *output, const float *samples, size_t size);
+
+// samples between an input and its filtered output, input is
+// collected into blocks of this many samples per transform
+unsigned int pk_fftfilt_ff_delay(pk_fftfilt_ff *f);
+
+// destroy the FFT filter object
+void pk_fftfilt_ff_destroy(pk_fftfilt_ff *f);
+
+// pk_complex
+pk_fftfilt_cc *pk_fftfilt_cc_create(unsigned int order, unsigned int nfft, const pk_complex *coeff);
+void pk_fftfilt_cc_load(pk_fftfilt_cc *f, const pk_complex *coeff);
+void pk_fftfilt_cc_execute(pk_fftfilt_cc *f, pk_complex *output, const pk_complex *samples, size_t size);
+unsigned int pk_fftfilt_cc_delay(pk_fftfilt_cc *f);
+void pk_fftfilt_cc_destroy(pk_fftfilt_cc *f);
+
 
 /* Second-order IIR alternate direct form I */
 // forward declarations of the second-order IIR filter
@@ -524,9 +1023,100 @@ void pk_firdes_srrc(
 
 /* fec and error detection objects */
 // algorithm comes from Kenneth W. Finnegan's APRS thesis.
-// this particular CRC function is appropriate for AX.25
+// this particular CRC function is appropriate for AX.25,
+// it returns the register before the final inversion
 unsigned int crc_ax25_byte(const unsigned char *data, size_t size);
 
+/* CRC engine */
+// common parameter sets
+//   PK_CRC_AX25      poly 0x1021 reflected, init 0xffff, xorout 0xffff
+//   PK_CRC_16_CCITT  poly 0x1021, init 0xffff, xorout 0x0000
+//   PK_CRC_32        poly 0x04c11db7 reflected, init and xorout 0xffffffff
+typedef enum
+{
+    PK_CRC_AX25,
+    PK_CRC_16_CCITT,
+    PK_CRC_32
+} pk_crc_preset;
+
+// forward declaration of the CRC object
+typedef struct pk_crc_s pk_crc;
+
+// create a table driven CRC of width 8 to 32 bits. poly, init and
+// xorout are in normal bit order, a non-zero reflect feeds bytes lsb
+// first and returns the reflected register
+pk_crc *pk_crc_create(
+    unsigned int width,
+    uint32_t poly,
+    int reflect,
+    uint32_t init,
+    uint32_t xorout
+);
+
+// create a CRC from one of the common parameter sets
+pk_crc *pk_crc_create_preset(pk_crc_preset preset);
+
+// streaming interface, start from the init register, update it
+// over any number of calls and apply xorout at the end
+uint32_t pk_crc_init(pk_crc *c);
+uint32_t pk_crc_update(pk_crc *c, uint32_t reg, const unsigned char *data, size_t size);
+uint32_t pk_crc_final(pk_crc *c, uint32_t reg);
+
+// CRC of a whole message
+uint32_t pk_crc_compute(pk_crc *c, const unsigned char *data, size_t size);
+
+// destroy the CRC object
+void pk_crc_destroy(pk_crc *c);
+
+/* Convolutional encoder */
+// forward declaration of the encoder object
+typedef struct pk_convenc_s pk_convenc;
+
+// create a K = 7 rate 1/2 encoder with the CCSDS generators
+// 0171 and 0133, the second output inverted
+pk_convenc *pk_convenc_create(void);
+
+// encode a sequence of bits into two output bits each
+void pk_convenc_process(pk_convenc *enc, const unsigned char *bits, size_t num);
+
+// read the encoded bits
+unsigned char *pk_convenc_read(pk_convenc *enc, size_t *nitems);
+
+// return the encoder to the all zero state
+void pk_convenc_reset(pk_convenc *enc);
+
+// destroy the encoder object
+void pk_convenc_destroy(pk_convenc *enc);
+
+/* Viterbi decoder */
+// forward declaration of the decoder object
+typedef struct pk_viterbi_s pk_viterbi;
+
+// create a soft decision Viterbi decoder for the CCSDS K = 7
+// rate 1/2 code, add-compare-select runs on SSE2 or AVX2 when available
+pk_viterbi *pk_viterbi_create(void);
+
+// decode soft symbols where 0 is a confident 0 and 255 a confident 1.
+// bits are traced back in chunks and come out with some delay
+void pk_viterbi_process(pk_viterbi *v, const unsigned char *soft, size_t num);
+
+// trace back and output everything still held, at the end of a stream.
+// an unpaired last symbol is dropped and the decoder is reset
+void pk_viterbi_flush(pk_viterbi *v);
+
+// as flush, for a stream the encoder ended with six zero bits, tracing
+// back from the all zero state so the last bits are decoded reliably
+void pk_viterbi_terminate(pk_viterbi *v);
+
+// read the bits decoded by the last process or flush
+unsigned char *pk_viterbi_read(pk_viterbi *v, size_t *nitems);
+
+// return the decoder to the all zero state
+void pk_viterbi_reset(pk_viterbi *v);
+
+// destroy the decoder object
+void pk_viterbi_destroy(pk_viterbi *v);
+
 
 /* Framer and deframer objects */
 // forward declaration for the AX.25 framer/deframer objects
@@ -545,10 +1135,25 @@ void pk_ax25_framer_process(
     size_t size
 );
 
+// execute the framer on a sequence of packed bytes,
+// producing only packed output bits
+void pk_ax25_framer_process_packed(
+    pk_ax25_framer *f,
+    const unsigned char *bytes,
+    size_t size
+);
+
+// NRZI encode the output, a zero toggles the line level
+void pk_ax25_framer_set_nrzi(pk_ax25_framer *f, int enable);
+
 // read the output of the framer
 // Also provides an optional count of the number of items
 unsigned char *pk_ax25_framer_read(pk_ax25_framer *f, size_t *out_nitems);
 
+// read the packed output, eight bits to a byte with the first bit
+// in the lsb. also provides an optional count of the number of bits
+unsigned char *pk_ax25_framer_read_packed(pk_ax25_framer *f, size_t *out_nbits);
+
 // destroy the AX.25 framer object
 void pk_ax25_framer_destroy(pk_ax25_framer *f);
 
@@ -568,9 +1173,46 @@ void pk_ax25_deframer_process(
     size_t size
 );
 
+// execute a deframer on packed bits, eight to a byte
+// with the first bit received in the lsb
+void pk_ax25_deframer_process_packed(
+    pk_ax25_deframer *df,
+    const unsigned char *bytes,
+    size_t size
+);
+
 // destroy the AX.25 deframer
 void pk_ax25_deframer_destroy(pk_ax25_deframer *df);
 
+/* G3RUH deframer */
+// forward declaration for the G3RUH receive chain
+typedef struct pk_g3ruh_deframer_s pk_g3ruh_deframer;
+
+// create a receive chain for 9600 baud G3RUH bit streams that
+// descrambles with 1 + x^12 + x^17, decodes NRZI and deframes AX.25
+// in one pass. frames go to the callback as with the AX.25 deframer
+pk_g3ruh_deframer *pk_g3ruh_deframer_create(
+    void *info,
+    void (*callback_ptr)(int valid, unsigned char *payload, void *info, size_t size)
+);
+
+// execute the chain on a sequence of demodulated bits
+void pk_g3ruh_deframer_process(
+    pk_g3ruh_deframer *g,
+    const unsigned char *bits,
+    size_t size
+);
+
+// execute the chain on packed bits with the first bit in the lsb
+void pk_g3ruh_deframer_process_packed(
+    pk_g3ruh_deframer *g,
+    const unsigned char *bytes,
+    size_t size
+);
+
+// destroy the G3RUH receive chain
+void pk_g3ruh_deframer_destroy(pk_g3ruh_deframer *g);
+
 
 /* Sequence generators and objects */
 /* m-sequence object */
@@ -585,6 +1227,14 @@ pk_lfsr *pk_lfsr_create(unsigned int n, uint32_t start);
 // returns the state of the lfsr
 uint32_t pk_lfsr_execute(pk_lfsr *l, int *out_period);
 
+// execute the lfsr num times, up to 64, and return the low bit of
+// each new state with the first in the lsb
+uint64_t pk_lfsr_execute_word(pk_lfsr *l, unsigned int num, int *out_period);
+
+// skip ahead num steps in O(log num) and return the new state,
+// lets separate pieces of a long sequence be generated independently
+uint32_t pk_lfsr_jump(pk_lfsr *l, size_t num, int *out_period);
+
 // destroy the lfsr object
 void pk_lfsr_destroy(pk_lfsr *l);
 
@@ -603,6 +1253,12 @@ pk_add_scrambler *pk_add_scrambler_create(unsigned int n, uint32_t start);
 // insert some input and return an output bit from the scrambler
 unsigned char pk_add_scrambler_execute(pk_add_scrambler *as, unsigned char input);
 
+// scramble num bits, up to 64, packed with the first in the lsb
+uint64_t pk_add_scrambler_execute_word(pk_add_scrambler *as, uint64_t input, unsigned int num);
+
+// skip ahead num bits without scrambling them
+void pk_add_scrambler_jump(pk_add_scrambler *as, size_t num);
+
 // destroy the scrambler object
 void pk_add_scrambler_destroy(pk_add_scrambler *as);
 
@@ -614,6 +1270,9 @@ pk_mult_scrambler *pk_mult_scrambler_create(unsigned int n, uint32_t start);
 // insert some input and return an output bit from the scrambler
 unsigned char pk_mult_scrambler_execute(pk_mult_scrambler *ms, unsigned char input);
 
+// scramble num bits, up to 64, packed with the first in the lsb
+uint64_t pk_mult_scrambler_execute_word(pk_mult_scrambler *ms, uint64_t input, unsigned int num);
+
 // destroy the scrambler object
 void pk_mult_scrambler_destroy(pk_mult_scrambler *ms);
 
@@ -625,6 +1284,9 @@ pk_mult_descrambler *pk_mult_descrambler_create(unsigned int n, uint32_t start);
 // insert a scrambled bit and return the next unscrambled bit
 unsigned char pk_mult_descrambler_execute(pk_mult_descrambler *md, unsigned char input);
 
+// descramble num bits, up to 64, packed with the first in the lsb
+uint64_t pk_mult_descrambler_execute_word(pk_mult_descrambler *md, uint64_t input, unsigned int num);
+
 // destroy the descrambler object
 void pk_mult_descrambler_destroy(pk_mult_descrambler *md);
 
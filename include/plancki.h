@@ -50,6 +50,18 @@
 #define AX25_FCS_BYTES  2
 #define AX25_CRC_MAGIC  0xf0b8
 
+// SIMD dispatch settings
+// x86 kernels are compiled per function with target attributes
+// and selected at runtime, NEON is assumed when the compiler enables it
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define PK_X86_SIMD 1
+#define PK_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define PK_ARM_NEON 1
+#endif
+
 // maximal polynomial table
 static uint32_t lfsr_poly_tab[] = {
     0x000e4001, 0x00040801, 0x00021001, 0x0001a011, // 19, 18, 17, 16
@@ -59,6 +71,20 @@ static uint32_t lfsr_poly_tab[] = {
     0x0000000d, 0x00000007,                         //  3,  2
 };
 
+/* memory allocation */
+// all storage is aligned to a cache line, which also
+// covers the widest vector loads
+#define PK_ALIGN 64
+
+// allocate through the configured hooks, exits when out of memory
+void *pk_malloc(size_t size);
+void *pk_calloc(size_t num, size_t size);
+
+// grow or shrink, keeping the first min(old_size, new_size) bytes.
+// shrinking hands back the same block
+void *pk_realloc(void *ptr, size_t old_size, size_t new_size);
+void pk_free(void *ptr);
+
 /* common math functions */
 // L2 distance for float complex
 float pk_dist_cf(float complex a, float complex b);
@@ -69,4 +95,106 @@ unsigned int pk_next2pow(unsigned int num);
 // next raised power of 2
 unsigned int pk_next2pow2(unsigned int num);
 
+/* template type hooks */
+// templates are expanded per type suffix, these flag fixed point and
+// complex types and pick the accumulator wide enough for a dot product,
+// the conjugate applied to sequences and how an accumulator narrows
+// back into the output type
+#define PK_FIXED_ff 0
+#define PK_FIXED_cc 0
+#define PK_FIXED_uu 0
+#define PK_FIXED_ii 0
+#define PK_FIXED_qq 1
+
+#define PK_COMPLEX_ff 0
+#define PK_COMPLEX_cc 1
+#define PK_COMPLEX_uu 0
+#define PK_COMPLEX_ii 0
+#define PK_COMPLEX_qq 0
+
+typedef float pk_acc_ff;
+typedef float complex pk_acc_cc;
+typedef unsigned char pk_acc_uu;
+typedef int pk_acc_ii;
+typedef int64_t pk_acc_qq;
+
+#define pk_conj_ff(x) (x)
+#define pk_conj_cc(x) conjf(x)
+#define pk_conj_uu(x) (x)
+#define pk_conj_ii(x) (x)
+#define pk_conj_qq(x) (x)
+
+// the scalar dot product term in * conj(seq), floats are multiplied
+// in double like the original portable loop so its output is unchanged
+#define pk_mulconj_ff(x, y) ((x) * (double) (y))
+#define pk_mulconj_cc(x, y) ((x) * conj(y))
+#define pk_mulconj_uu(x, y) ((x) * (y))
+#define pk_mulconj_ii(x, y) ((x) * (y))
+#define pk_mulconj_qq(x, y) ((x) * (y))
+
+// saturate a wide value into Q15
+static inline int16_t pk_sat_q15(int64_t x)
+{
+    return x > INT16_MAX ? INT16_MAX : (x < INT16_MIN ? INT16_MIN : (int16_t) x);
+}
+
+#define pk_narrow_ff(x) (x)
+#define pk_narrow_cc(x) (x)
+#define pk_narrow_uu(x) (x)
+#define pk_narrow_ii(x) (x)
+
+// Q30 products back to Q15 with rounding
+#define pk_narrow_qq(x) pk_sat_q15(((x) + (1 << 14)) >> 15)
+
+/* dot product kernels */
+// computes the sum of in[i] * conj(seq[i]) over size items
+typedef float (*pk_dotprod_ff_kernel)(const float *seq, const float *in, size_t size);
+typedef float complex (*pk_dotprod_cc_kernel)(const float complex *seq, const float complex *in, size_t size);
+typedef unsigned char (*pk_dotprod_uu_kernel)(const unsigned char *seq, const unsigned char *in, size_t size);
+typedef int (*pk_dotprod_ii_kernel)(const int *seq, const int *in, size_t size);
+typedef int16_t (*pk_dotprod_qq_kernel)(const int16_t *seq, const int16_t *in, size_t size);
+
+// pick the best vector kernel supported by the running cpu
+// returns NULL when only the scalar path is available
+pk_dotprod_ff_kernel pk_dotprod_ff_select(void);
+pk_dotprod_cc_kernel pk_dotprod_cc_select(void);
+pk_dotprod_uu_kernel pk_dotprod_uu_select(void);
+pk_dotprod_ii_kernel pk_dotprod_ii_select(void);
+pk_dotprod_qq_kernel pk_dotprod_qq_select(void);
+
+// instruction sets a kernel can be pinned to, so every path the
+// running cpu supports can be checked against the others
+typedef enum
+{
+    PK_ISA_SCALAR,
+    PK_ISA_SSE2,
+    PK_ISA_AVX2,
+    PK_ISA_AVX512,
+    PK_ISA_NEON
+} pk_isa;
+
+// non-zero when both this build and the running cpu support isa,
+// AVX2 includes FMA and AVX512 stands for AVX-512F
+int pk_isa_supported(pk_isa isa);
+
+// the vector kernel for isa, NULL for the scalar path, when the isa
+// is unsupported or when the type has no kernel for it
+pk_dotprod_ff_kernel pk_dotprod_ff_isa(pk_isa isa);
+pk_dotprod_cc_kernel pk_dotprod_cc_isa(pk_isa isa);
+pk_dotprod_uu_kernel pk_dotprod_uu_isa(pk_isa isa);
+pk_dotprod_ii_kernel pk_dotprod_ii_isa(pk_isa isa);
+pk_dotprod_qq_kernel pk_dotprod_qq_isa(pk_isa isa);
+
+// pin a dot product object to the kernel for isa, PK_ISA_SCALAR picks
+// the scalar path. returns 0 when there is no kernel for isa
+int pk_dotprod_ff_set_isa(pk_dotprod_ff *dp, pk_isa isa);
+int pk_dotprod_cc_set_isa(pk_dotprod_cc *dp, pk_isa isa);
+int pk_dotprod_uu_set_isa(pk_dotprod_uu *dp, pk_isa isa);
+int pk_dotprod_ii_set_isa(pk_dotprod_ii *dp, pk_isa isa);
+int pk_dotprod_qq_set_isa(pk_dotprod_qq *dp, pk_isa isa);
+
+/* Viterbi decoder */
+// pin the add-compare-select kernel, returns 0 when isa is unsupported
+int pk_viterbi_set_isa(pk_viterbi *v, pk_isa isa);
+
 #endif
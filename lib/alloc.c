@@ -0,0 +1,107 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Paul Uri David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "plancki.h"
+
+// default hooks sit on top of the C11 aligned allocator,
+// which wants the size to be a multiple of the alignment
+static void *alloc_default(size_t size, size_t align, void *ctx)
+{
+    (void) ctx;
+    size = (size + align - 1) & ~(align - 1);
+    return aligned_alloc(align, size);
+}
+
+static void free_default(void *ptr, void *ctx)
+{
+    (void) ctx;
+    free(ptr);
+}
+
+static pk_alloc_func alloc_hook = alloc_default;
+static pk_free_func free_hook = free_default;
+static void *alloc_ctx = NULL;
+
+void pk_set_allocator(pk_alloc_func alloc, pk_free_func release, void *ctx)
+{
+    if (alloc == NULL || release == NULL) {
+        alloc_hook = alloc_default;
+        free_hook = free_default;
+        alloc_ctx = NULL;
+        return;
+    }
+
+    alloc_hook = alloc;
+    free_hook = release;
+    alloc_ctx = ctx;
+}
+
+void *pk_malloc(size_t size)
+{
+    // never ask the hook for an empty allocation
+    void *ptr = alloc_hook(size > 0 ? size : 1, PK_ALIGN, alloc_ctx);
+
+    if (!ptr) {
+        fprintf(stderr, "unable to allocate %zu bytes!\n", size);
+        exit(1);
+    }
+
+    assert(((uintptr_t) ptr & (PK_ALIGN - 1)) == 0);
+    return ptr;
+}
+
+void *pk_calloc(size_t num, size_t size)
+{
+    if (size != 0 && num > SIZE_MAX / size) {
+        fprintf(stderr, "unable to allocate %zu items of %zu bytes!\n", num, size);
+        exit(1);
+    }
+
+    void *ptr = pk_malloc(num * size);
+    memset(ptr, 0, num * size);
+    return ptr;
+}
+
+void *pk_realloc(void *ptr, size_t old_size, size_t new_size)
+{
+    // the hooks can't resize in place, but a shrinking
+    // block already holds everything that is kept
+    if (ptr && new_size <= old_size)
+        return ptr;
+
+    void *new_ptr = pk_malloc(new_size);
+
+    if (ptr) {
+        memcpy(new_ptr, ptr, old_size);
+        pk_free(ptr);
+    }
+
+    return new_ptr;
+}
+
+void pk_free(void *ptr)
+{
+    if (ptr)
+        free_hook(ptr, alloc_ctx);
+}
@@ -24,7 +24,11 @@
 
 #include "plancki.h"
 
+#include <stdatomic.h>
+
 /* Generic circular buffer */
+// the storage is mirrored, every item is written twice so
+// the whole window can be read in place as a single span
 typedef struct pk_circ_XX_s
 {
     <I> *buffer;
@@ -37,7 +41,7 @@ typedef struct pk_circ_XX_s
 
 pk_circ_XX *pk_circ_XX_create(unsigned int size)
 {
-    pk_circ_XX *cb = malloc(sizeof(pk_circ_XX));
+    pk_circ_XX *cb = pk_malloc(sizeof(pk_circ_XX));
     unsigned int exponent = pk_next2pow(size);
     unsigned int new_size = pk_next2pow2(size);
 
@@ -45,7 +49,7 @@ pk_circ_XX *pk_circ_XX_create(unsigned int size)
     assert(cb->diff >= 0);
 
     cb->buf_size = new_size;
-    cb->buffer = calloc(cb->buf_size, sizeof(<I>));
+    cb->buffer = pk_calloc(2 * cb->buf_size, sizeof(<I>));
     cb->mask = (1 << exponent) - 1;
     cb->count = 0;
     cb->index = 0;
@@ -55,18 +59,46 @@ pk_circ_XX *pk_circ_XX_create(unsigned int size)
 
 void pk_circ_XX_push(pk_circ_XX *cb, <I> item)
 {
-    cb->buffer[(cb->index++) & cb->mask] = item;
+    unsigned int pos = (cb->index++) & cb->mask;
+    cb->buffer[pos] = item;
+    cb->buffer[pos + cb->buf_size] = item;
     cb->count = cb->count > cb->buf_size ? 0 : cb->count + 1;
 }
 
+void pk_circ_XX_append(pk_circ_XX *cb, const <I> *items, size_t num)
+{
+    // same count as pushing each item in turn
+    cb->count = (cb->count + num) % (cb->buf_size + 2);
+
+    // only the newest buf_size items survive
+    if (num > cb->buf_size) {
+        cb->index += num - cb->buf_size;
+        items += num - cb->buf_size;
+        num = cb->buf_size;
+    }
+
+    size_t start = cb->index & cb->mask;
+    size_t first = cb->buf_size - start < num ? cb->buf_size - start : num;
+
+    memcpy(cb->buffer + start, items, first * sizeof(<I>));
+    memcpy(cb->buffer + start + cb->buf_size, items, first * sizeof(<I>));
+    memcpy(cb->buffer, items + first, (num - first) * sizeof(<I>));
+    memcpy(cb->buffer + cb->buf_size, items + first, (num - first) * sizeof(<I>));
+
+    cb->index += num;
+}
+
+const <O> *pk_circ_XX_view(pk_circ_XX *cb)
+{
+    return cb->buffer + ((cb->diff + cb->index) & cb->mask);
+}
+
 void pk_circ_XX_read(pk_circ_XX *cb, <O> *output, size_t num)
 {
     if (num > cb->buf_size || num == 0)
         num = cb->buf_size;
 
-    size_t i;
-    for (i = 0; i < num; i++)
-        output[i] = cb->buffer[(i + cb->diff + cb->index) & cb->mask];
+    memcpy(output, pk_circ_XX_view(cb), num * sizeof(<O>));
 }
 
 <O> pk_circ_XX_pop(pk_circ_XX *cb)
@@ -88,8 +120,8 @@ void pk_circ_XX_clear(pk_circ_XX *cb)
 
 void pk_circ_XX_destroy(pk_circ_XX *cb)
 {
-    free(cb->buffer);
-    free(cb);
+    pk_free(cb->buffer);
+    pk_free(cb);
 }
 
 
@@ -103,26 +135,33 @@ typedef struct pk_block_XX_s
 
 pk_block_XX *pk_block_XX_create(size_t size)
 {
-    pk_block_XX *b = malloc(sizeof(pk_block_XX));
+    pk_block_XX *b = pk_malloc(sizeof(pk_block_XX));
     b->size = size;
     b->nitems = 0;
-    b->output = calloc(size, sizeof(<O>));
+    b->output = pk_calloc(size, sizeof(<O>));
     return b;
 }
 
 void pk_block_XX_resize(pk_block_XX *b, size_t new_size)
 {
-    <O> *new_output;
-    new_output = realloc(b->output, new_size * sizeof(<O>));
+    b->output = pk_realloc(b->output, b->size * sizeof(<O>), new_size * sizeof(<O>));
+    b->size = new_size;
 
-    if (!new_output) {
-        free(b->output);
-        fprintf(stderr, "unable to reallocate a new block size!\n");
-        exit(1);
-    }
+    if (b->nitems > new_size)
+        b->nitems = new_size;
+}
 
-    b->output = new_output;
-    b->size = new_size;
+void pk_block_XX_reserve(pk_block_XX *b, size_t size)
+{
+    if (size <= b->size)
+        return;
+
+    // grow geometrically so repeated appends stay amortized O(1)
+    size_t new_size = b->size > 0 ? b->size : 1;
+    while (new_size < size)
+        new_size *= 2;
+
+    pk_block_XX_resize(b, new_size);
 }
 
 <O> *pk_block_XX_ptr(pk_block_XX *b)
@@ -132,12 +171,32 @@ void pk_block_XX_resize(pk_block_XX *b, size_t new_size)
 
 void pk_block_XX_push(pk_block_XX *b, <I> item)
 {
-    while (b->nitems > b->size)
-        pk_block_XX_resize(b, 2*b->size);
+    if (b->nitems == b->size)
+        pk_block_XX_reserve(b, b->nitems + 1);
 
     b->output[b->nitems++] = item;
 }
 
+void pk_block_XX_append(pk_block_XX *b, const <I> *items, size_t num)
+{
+    pk_block_XX_reserve(b, b->nitems + num);
+
+    memcpy(b->output + b->nitems, items, num * sizeof(<I>));
+    b->nitems += num;
+}
+
+<O> *pk_block_XX_begin_write(pk_block_XX *b, size_t num)
+{
+    pk_block_XX_reserve(b, b->nitems + num);
+    return b->output + b->nitems;
+}
+
+void pk_block_XX_commit(pk_block_XX *b, size_t num)
+{
+    assert(b->nitems + num <= b->size);
+    b->nitems += num;
+}
+
 size_t pk_block_XX_nitems(pk_block_XX *b)
 {
     return b->nitems;
@@ -155,76 +214,97 @@ void pk_block_XX_clear(pk_block_XX *b)
 
 void pk_block_XX_destroy(pk_block_XX *b)
 {
-    free(b->output);
-    free(b);
+    pk_free(b->output);
+    pk_free(b);
 }
 
 
-/* Generic data queue using a linked list*/
-// TODO: Improve efficiency by pre-allocating a pool
-// instead of malloc'ing for each element
-typedef struct pk_queue_XX_node_s
-{
-    <I> value;
-    struct pk_queue_XX_node_s *next;
-} pk_queue_XX_node;
+/* Generic data queue using a growable ring array */
+// capacity doubles when full, so inserts are amortized O(1)
+#define QUEUE_MIN_SIZE 16
 
 typedef struct pk_queue_XX_s
 {
+    <I> *buffer;
+    size_t size;
+    size_t begin;
     size_t nitems;
-    pk_queue_XX_node *begin;
-    pk_queue_XX_node *curr;
 } pk_queue_XX;
 
 pk_queue_XX *pk_queue_XX_create()
 {
-    pk_queue_XX *q = malloc(sizeof(pk_queue_XX));
+    pk_queue_XX *q = pk_malloc(sizeof(pk_queue_XX));
 
+    q->size = QUEUE_MIN_SIZE;
+    q->buffer = pk_malloc(q->size * sizeof(<I>));
+    q->begin = 0;
     q->nitems = 0;
-    q->begin = NULL;
-    q->curr = NULL;
 
     return q;
 }
 
+// copy num items starting at the front of the queue
+static void queue_XX_copy(pk_queue_XX *q, <I> *output, size_t num)
+{
+    size_t first = q->size - q->begin < num ? q->size - q->begin : num;
+    memcpy(output, q->buffer + q->begin, first * sizeof(<I>));
+    memcpy(output + first, q->buffer, (num - first) * sizeof(<I>));
+}
+
+void pk_queue_XX_reserve(pk_queue_XX *q, size_t size)
+{
+    if (size <= q->size)
+        return;
+
+    size_t new_size = q->size;
+    while (new_size < size)
+        new_size <<= 1;
+
+    // unwrap the items into the front of the new storage
+    <I> *new_buffer = pk_malloc(new_size * sizeof(<I>));
+
+    queue_XX_copy(q, new_buffer, q->nitems);
+    pk_free(q->buffer);
+
+    q->buffer = new_buffer;
+    q->size = new_size;
+    q->begin = 0;
+}
+
 void pk_queue_XX_insert(pk_queue_XX *q, <I> item)
 {
-    if (q->nitems == 0) {
-        q->begin = malloc(sizeof(pk_queue_XX_node));
-        q->begin->value = item;
-        q->begin->next = NULL;
-        q->curr = q->begin;
-    } else {
-        pk_queue_XX_node *node = malloc(sizeof(pk_queue_XX_node));
-        node->value = item;
-        node->next = NULL;
-        q->curr->next = node;
-        q->curr = node;
-    }
+    if (q->nitems == q->size)
+        pk_queue_XX_reserve(q, 2 * q->size);
 
+    q->buffer[(q->begin + q->nitems) & (q->size - 1)] = item;
     q->nitems++;
 }
 
+void pk_queue_XX_append(pk_queue_XX *q, const <I> *items, size_t num)
+{
+    pk_queue_XX_reserve(q, q->nitems + num);
+
+    size_t end = (q->begin + q->nitems) & (q->size - 1);
+    size_t first = q->size - end < num ? q->size - end : num;
+    memcpy(q->buffer + end, items, first * sizeof(<I>));
+    memcpy(q->buffer, items + first, (num - first) * sizeof(<I>));
+
+    q->nitems += num;
+}
+
 void pk_queue_XX_dequeue(pk_queue_XX *q)
 {
     if (q->nitems == 0)
         return;
 
-    if (q->begin->next != NULL) {
-        pk_queue_XX_node *node = q->begin->next;
-        free(q->begin);
-        q->begin = node;
-    } else {
-        free(q->begin);
-    }
-
+    q->begin = (q->begin + 1) & (q->size - 1);
     q->nitems--;
 }
 
 void pk_queue_XX_clear(pk_queue_XX *q)
 {
-    while (q->nitems != 0)
-        pk_queue_XX_dequeue(q);
+    q->begin = 0;
+    q->nitems = 0;
 }
 
 size_t pk_queue_XX_nitems(pk_queue_XX *q)
@@ -237,18 +317,121 @@ void pk_queue_XX_read(pk_queue_XX *q, <O> *output, size_t num)
     if (num > q->nitems || num == 0)
         num = q->nitems;
 
-    pk_queue_XX_node *node = q->begin;
-
-    size_t i;
-    for (i = 0; i < num; i++) {
-        output[i] = node->value;
-        node = node->next;
-    }
+    queue_XX_copy(q, output, num);
 }
 
 void pk_queue_XX_destroy(pk_queue_XX *q)
 {
-    pk_queue_XX_clear(q);
+    pk_free(q->buffer);
+    pk_free(q);
+}
+
+
+/* Lock-free single-producer/single-consumer ring buffer */
+// one thread may write while another reads without a lock,
+// the indices run freely and are masked on access
+typedef struct pk_ring_XX_s
+{
+    // shared and read-only after creation
+    <I> *buffer;
+    size_t size;
+    size_t mask;
+
+    // owned by the producer, keeps a stale copy of the tail.
+    // head and tail each start a cache line of their own, pk_malloc
+    // hands out PK_ALIGN aligned memory so the alignment holds
+    _Alignas(PK_ALIGN) atomic_size_t head;
+    size_t tail_cache;
+
+    // owned by the consumer, keeps a stale copy of the head
+    _Alignas(PK_ALIGN) atomic_size_t tail;
+    size_t head_cache;
+} pk_ring_XX;
+
+pk_ring_XX *pk_ring_XX_create(size_t size)
+{
+    pk_ring_XX *r = pk_malloc(sizeof(pk_ring_XX));
 
-    free(q);
+    // round the capacity up to a power of 2
+    r->size = 1;
+    while (r->size < size)
+        r->size <<= 1;
+
+    r->mask = r->size - 1;
+    r->buffer = pk_calloc(r->size, sizeof(<I>));
+
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+    r->tail_cache = 0;
+    r->head_cache = 0;
+
+    return r;
+}
+
+size_t pk_ring_XX_write(pk_ring_XX *r, const <I> *input, size_t num)
+{
+    size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+
+    // only look at the consumer when the cached tail is not enough
+    if (r->size - (head - r->tail_cache) < num)
+        r->tail_cache = atomic_load_explicit(&r->tail, memory_order_acquire);
+
+    size_t space = r->size - (head - r->tail_cache);
+    if (num > space)
+        num = space;
+
+    // copy in at most two contiguous pieces
+    size_t start = head & r->mask;
+    size_t first = r->size - start < num ? r->size - start : num;
+    memcpy(r->buffer + start, input, first * sizeof(<I>));
+    memcpy(r->buffer, input + first, (num - first) * sizeof(<I>));
+
+    atomic_store_explicit(&r->head, head + num, memory_order_release);
+    return num;
+}
+
+size_t pk_ring_XX_read(pk_ring_XX *r, <O> *output, size_t num)
+{
+    size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+
+    // only look at the producer when the cached head is not enough
+    if (r->head_cache - tail < num)
+        r->head_cache = atomic_load_explicit(&r->head, memory_order_acquire);
+
+    size_t avail = r->head_cache - tail;
+    if (num > avail)
+        num = avail;
+
+    size_t start = tail & r->mask;
+    size_t first = r->size - start < num ? r->size - start : num;
+    memcpy(output, r->buffer + start, first * sizeof(<O>));
+    memcpy(output + first, r->buffer, (num - first) * sizeof(<O>));
+
+    atomic_store_explicit(&r->tail, tail + num, memory_order_release);
+    return num;
+}
+
+size_t pk_ring_XX_nitems(pk_ring_XX *r)
+{
+    size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+    return head - tail;
+}
+
+size_t pk_ring_XX_space(pk_ring_XX *r)
+{
+    size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+    return r->size - (head - tail);
+}
+
+size_t pk_ring_XX_size(pk_ring_XX *r)
+{
+    return r->size;
+}
+
+void pk_ring_XX_destroy(pk_ring_XX *r)
+{
+    pk_free(r->buffer);
+    pk_free(r);
 }
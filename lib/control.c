@@ -21,3 +21,268 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
  * THE SOFTWARE.
  */
+
+#include "plancki.h"
+
+/* Symbol timing recovery */
+// the interpolator runs on the last four input samples and produces
+// a point between the middle two, so the timing error detector sees
+// samples at the estimated symbol instants (and midpoints for Gardner)
+typedef struct pk_symsync_s
+{
+    float sps;
+    pk_symsync_ted ted;
+
+    // loop filter gains and integrator, in samples
+    float kp;
+    float ki;
+    float integ;
+
+    // nominal spacing of interpolants and the time until the
+    // next one, relative to the newest input sample
+    float step;
+    float next;
+
+    // toggles between symbol and midpoint interpolants for Gardner
+    int strobe;
+
+    float complex hist[4];
+    float complex mid;
+    float complex prev;
+} pk_symsync;
+
+// cubic Lagrange interpolation in Farrow form between x[1] and x[2]
+static float complex symsync_farrow(const float complex *x, float mu)
+{
+    float complex c0 = x[1];
+    float complex c1 = -x[0] / 3.0f - x[1] / 2.0f + x[2] - x[3] / 6.0f;
+    float complex c2 = x[0] / 2.0f - x[1] + x[2] / 2.0f;
+    float complex c3 = (x[3] - x[0]) / 6.0f + (x[1] - x[2]) / 2.0f;
+
+    return ((c3 * mu + c2) * mu + c1) * mu + c0;
+}
+
+// hard decision used by the decision directed detector
+static float complex symsync_slice(float complex y)
+{
+    float re = crealf(y) > 0 ? 1.0f : (crealf(y) < 0 ? -1.0f : 0.0f);
+    float im = cimagf(y) > 0 ? 1.0f : (cimagf(y) < 0 ? -1.0f : 0.0f);
+    return re + I * im;
+}
+
+void pk_symsync_set_bandwidth(pk_symsync *ss, float bandwidth)
+{
+    // critically damped second order loop, the detector gain is taken
+    // as one for unit amplitude symbols
+    float zeta = 1.0f / sqrtf(2.0f);
+    float theta = bandwidth / (zeta + 0.25f / zeta);
+    float d = 1.0f + 2.0f * zeta * theta + theta * theta;
+
+    ss->kp = 4.0f * zeta * theta / d;
+    ss->ki = 4.0f * theta * theta / d;
+}
+
+pk_symsync *pk_symsync_create(float sps, pk_symsync_ted ted, float bandwidth)
+{
+    if (sps < 2.0f) {
+        fprintf(stderr, "symbol sync needs at least 2 samples per symbol!\n");
+        exit(1);
+    }
+
+    pk_symsync *ss = pk_malloc(sizeof(pk_symsync));
+    ss->sps = sps;
+    ss->ted = ted;
+
+    pk_symsync_set_bandwidth(ss, bandwidth);
+    pk_symsync_reset(ss);
+
+    return ss;
+}
+
+void pk_symsync_reset(pk_symsync *ss)
+{
+    ss->integ = 0;
+    ss->step = ss->ted == PK_SYMSYNC_GARDNER ? ss->sps / 2.0f : ss->sps;
+    ss->next = 0;
+    ss->strobe = 1;
+
+    size_t i;
+    for (i = 0; i < 4; i++)
+        ss->hist[i] = 0;
+
+    ss->mid = 0;
+    ss->prev = 0;
+}
+
+// run the detector on a new symbol and return the loop correction
+static float symsync_error(pk_symsync *ss, float complex y)
+{
+    float e;
+    if (ss->ted == PK_SYMSYNC_GARDNER) {
+        e = crealf(ss->mid * conjf(y - ss->prev));
+    } else {
+        float complex a = symsync_slice(ss->prev);
+        float complex b = symsync_slice(y);
+        e = crealf(conjf(b) * ss->prev - conjf(a) * y);
+    }
+    ss->prev = y;
+
+    // loop filter output in fractions of a symbol
+    ss->integ += ss->ki * e;
+    return ss->kp * e + ss->integ;
+}
+
+// take one input sample and write out any symbols it completes
+static size_t symsync_push(pk_symsync *ss, float complex *output, float complex x)
+{
+    size_t nsym = 0;
+
+    ss->hist[0] = ss->hist[1];
+    ss->hist[1] = ss->hist[2];
+    ss->hist[2] = ss->hist[3];
+    ss->hist[3] = x;
+
+    // interpolants are due once they fall between the middle samples,
+    // at two per symbol and 2 sps that can be more than one per input
+    ss->next -= 1.0f;
+    while (ss->next < -1.0f) {
+        float mu = ss->next + 2.0f;
+        float complex y = symsync_farrow(ss->hist, mu > 0 ? mu : 0);
+
+        if (ss->ted == PK_SYMSYNC_GARDNER && !ss->strobe) {
+            ss->mid = y;
+            ss->strobe = 1;
+            ss->next += ss->step;
+            continue;
+        }
+
+        output[nsym++] = y;
+        ss->strobe = 0;
+
+        // retard or advance the next interpolant, bounded to half
+        // the nominal spacing so a noisy error cannot stall the loop
+        float v = symsync_error(ss, y) * ss->sps;
+        float step = ss->ted == PK_SYMSYNC_GARDNER ? ss->step - v / 2.0f : ss->step - v;
+
+        if (step < ss->step / 2.0f)
+            step = ss->step / 2.0f;
+        else if (step > 1.5f * ss->step)
+            step = 1.5f * ss->step;
+
+        ss->next += step;
+    }
+
+    return nsym;
+}
+
+size_t pk_symsync_execute(
+    pk_symsync *ss,
+    float complex *output,
+    const float complex *input,
+    size_t num)
+{
+    size_t nsym = 0;
+
+    size_t i;
+    for (i = 0; i < num; i++)
+        nsym += symsync_push(ss, output + nsym, input[i]);
+
+    return nsym;
+}
+
+size_t pk_symsync_execute_real(
+    pk_symsync *ss,
+    float *output,
+    const float *input,
+    size_t num)
+{
+    size_t nsym = 0;
+
+    // the bounded spacing lets an input complete at most one symbol
+    float complex y[2];
+
+    size_t i, k;
+    for (i = 0; i < num; i++) {
+        size_t n = symsync_push(ss, y, input[i]);
+        for (k = 0; k < n; k++)
+            output[nsym++] = crealf(y[k]);
+    }
+
+    return nsym;
+}
+
+void pk_symsync_destroy(pk_symsync *ss)
+{
+    pk_free(ss);
+}
+
+/* Costas carrier recovery */
+// decision directed QPSK carrier loop, the symbols are fed back once per
+// symbol and the correction is spread over the samples by an oscillator
+typedef struct pk_costas_s
+{
+    float samp_sym;
+
+    float kp;
+    float ki;
+
+    pk_nco *nco;
+} pk_costas;
+
+void pk_costas_set_bandwidth(pk_costas *cl, float bandwidth)
+{
+    float zeta = 1.0f / sqrtf(2.0f);
+    float theta = bandwidth / (zeta + 0.25f / zeta);
+    float d = 1.0f + 2.0f * zeta * theta + theta * theta;
+
+    cl->kp = 4.0f * zeta * theta / d;
+    cl->ki = 4.0f * theta * theta / d;
+}
+
+pk_costas *pk_costas_create(float samp_sym, float bandwidth)
+{
+    pk_costas *cl = pk_malloc(sizeof(pk_costas));
+    cl->samp_sym = samp_sym;
+    cl->nco = pk_nco_create(0, 1);
+
+    pk_costas_set_bandwidth(cl, bandwidth);
+
+    return cl;
+}
+
+// remove the current carrier estimate from the samples
+void pk_costas_mix(pk_costas *cl, float complex *output, const float complex *input, size_t num)
+{
+    pk_nco_mix_down(cl->nco, output, input, num);
+}
+
+// update the loop with a symbol taken from the mixed samples
+float pk_costas_update(pk_costas *cl, float complex symbol)
+{
+    float re = crealf(symbol);
+    float im = cimagf(symbol);
+
+    // normalized so the detector gain does not depend on the input level
+    float norm = fabsf(re) + fabsf(im);
+    if (norm == 0)
+        return 0;
+
+    float e = ((re > 0 ? im : -im) - (im > 0 ? re : -re)) / norm;
+
+    // the integrator holds the frequency in radians per symbol
+    pk_nco_adjust_phase(cl->nco, cl->kp * e);
+    pk_nco_adjust_frequency(cl->nco, cl->ki * e / cl->samp_sym);
+
+    return e;
+}
+
+float pk_costas_get_frequency(pk_costas *cl)
+{
+    return pk_nco_get_frequency(cl->nco);
+}
+
+void pk_costas_destroy(pk_costas *cl)
+{
+    pk_nco_destroy(cl->nco);
+    pk_free(cl);
+}
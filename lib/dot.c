@@ -0,0 +1,620 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Paul Uri David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "plancki.h"
+
+#if defined(PK_X86_SIMD)
+#include <immintrin.h>
+#elif defined(PK_ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/*
+ * Vectorized dot product kernels.
+ *
+ * Every kernel computes the sum of in[i] * conj(seq[i]). The vector
+ * kernels accumulate in a different order than the scalar template path
+ * so results can differ in the last bits for floating point types.
+ */
+
+#if defined(PK_X86_SIMD)
+
+/* float */
+PK_TARGET("sse2")
+static float dotprod_ff_sse2(const float *seq, const float *in, size_t size)
+{
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(in + i), _mm_loadu_ps(seq + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(in + i + 4), _mm_loadu_ps(seq + i + 4)));
+    }
+
+    float sum[4];
+    _mm_storeu_ps(sum, _mm_add_ps(acc0, acc1));
+
+    float result = (sum[0] + sum[1]) + (sum[2] + sum[3]);
+    for (; i < size; i++)
+        result += in[i] * seq[i];
+
+    return result;
+}
+
+PK_TARGET("avx2,fma")
+static float dotprod_ff_avx2(const float *seq, const float *in, size_t size)
+{
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(in + i), _mm256_loadu_ps(seq + i), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(in + i + 8), _mm256_loadu_ps(seq + i + 8), acc1);
+    }
+
+    __m256 acc = _mm256_add_ps(acc0, acc1);
+    __m128 half = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+
+    float sum[4];
+    _mm_storeu_ps(sum, half);
+
+    float result = (sum[0] + sum[1]) + (sum[2] + sum[3]);
+    for (; i < size; i++)
+        result += in[i] * seq[i];
+
+    return result;
+}
+
+PK_TARGET("avx512f")
+static float dotprod_ff_avx512(const float *seq, const float *in, size_t size)
+{
+    __m512 acc0 = _mm512_setzero_ps();
+    __m512 acc1 = _mm512_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(in + i), _mm512_loadu_ps(seq + i), acc0);
+        acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(in + i + 16), _mm512_loadu_ps(seq + i + 16), acc1);
+    }
+
+    // handle the tail with a mask instead of a scalar loop
+    for (; i < size; i += 16) {
+        __mmask16 mask = size - i >= 16 ? 0xffff : (__mmask16) ((1u << (size - i)) - 1);
+        __m512 a = _mm512_maskz_loadu_ps(mask, in + i);
+        __m512 b = _mm512_maskz_loadu_ps(mask, seq + i);
+        acc0 = _mm512_fmadd_ps(a, b, acc0);
+    }
+
+    return _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+}
+
+/* float complex */
+// the real part is the sum of in * seq over interleaved lanes,
+// the imaginary part comes from the swapped input, even lanes minus odd lanes
+PK_TARGET("sse2")
+static float complex dotprod_cc_sse2(const float complex *seq, const float complex *in, size_t size)
+{
+    const float *a = (const float *) in;
+    const float *b = (const float *) seq;
+
+    __m128 re = _mm_setzero_ps();
+    __m128 im = _mm_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 2 <= size; i += 2) {
+        __m128 x = _mm_loadu_ps(a + 2*i);
+        __m128 y = _mm_loadu_ps(b + 2*i);
+        __m128 xs = _mm_shuffle_ps(x, x, _MM_SHUFFLE(2, 3, 0, 1));
+        re = _mm_add_ps(re, _mm_mul_ps(x, y));
+        im = _mm_add_ps(im, _mm_mul_ps(xs, y));
+    }
+
+    float r[4], s[4];
+    _mm_storeu_ps(r, re);
+    _mm_storeu_ps(s, im);
+
+    float complex result = ((r[0] + r[1]) + (r[2] + r[3]))
+                         + I * ((s[0] - s[1]) + (s[2] - s[3]));
+    for (; i < size; i++)
+        result += in[i] * conjf(seq[i]);
+
+    return result;
+}
+
+PK_TARGET("avx2,fma")
+static float complex dotprod_cc_avx2(const float complex *seq, const float complex *in, size_t size)
+{
+    const float *a = (const float *) in;
+    const float *b = (const float *) seq;
+
+    __m256 re = _mm256_setzero_ps();
+    __m256 im = _mm256_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m256 x = _mm256_loadu_ps(a + 2*i);
+        __m256 y = _mm256_loadu_ps(b + 2*i);
+        __m256 xs = _mm256_permute_ps(x, _MM_SHUFFLE(2, 3, 0, 1));
+        re = _mm256_fmadd_ps(x, y, re);
+        im = _mm256_fmadd_ps(xs, y, im);
+    }
+
+    float r[8], s[8];
+    _mm256_storeu_ps(r, re);
+    _mm256_storeu_ps(s, im);
+
+    float complex result = ((r[0] + r[1]) + (r[2] + r[3])) + ((r[4] + r[5]) + (r[6] + r[7]))
+                         + I * (((s[0] - s[1]) + (s[2] - s[3])) + ((s[4] - s[5]) + (s[6] - s[7])));
+    for (; i < size; i++)
+        result += in[i] * conjf(seq[i]);
+
+    return result;
+}
+
+PK_TARGET("avx512f")
+static float complex dotprod_cc_avx512(const float complex *seq, const float complex *in, size_t size)
+{
+    const float *a = (const float *) in;
+    const float *b = (const float *) seq;
+
+    __m512 re = _mm512_setzero_ps();
+    __m512 im = _mm512_setzero_ps();
+
+    size_t i = 0;
+    for (; i < size; i += 8) {
+        __mmask16 mask = size - i >= 8 ? 0xffff : (__mmask16) ((1u << (2*(size - i))) - 1);
+        __m512 x = _mm512_maskz_loadu_ps(mask, a + 2*i);
+        __m512 y = _mm512_maskz_loadu_ps(mask, b + 2*i);
+        __m512 xs = _mm512_permute_ps(x, _MM_SHUFFLE(2, 3, 0, 1));
+        re = _mm512_fmadd_ps(x, y, re);
+        im = _mm512_fmadd_ps(xs, y, im);
+    }
+
+    // negate the odd lanes so one reduction gives even minus odd
+    const __m512 sign = _mm512_castsi512_ps(_mm512_set1_epi64(0x8000000000000000LL));
+    im = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(im), _mm512_castps_si512(sign)));
+
+    return _mm512_reduce_add_ps(re) + I * _mm512_reduce_add_ps(im);
+}
+
+/* integers */
+PK_TARGET("sse2")
+static int dotprod_ii_sse2(const int *seq, const int *in, size_t size)
+{
+    __m128i acc = _mm_setzero_si128();
+
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i *) (in + i));
+        __m128i y = _mm_loadu_si128((const __m128i *) (seq + i));
+
+        // sse2 lacks a packed 32-bit low multiply, so
+        // multiply even and odd lanes separately and merge
+        __m128i even = _mm_mul_epu32(x, y);
+        __m128i odd  = _mm_mul_epu32(_mm_srli_si128(x, 4), _mm_srli_si128(y, 4));
+        __m128i prod = _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                                          _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+        acc = _mm_add_epi32(acc, prod);
+    }
+
+    int32_t sum[4];
+    _mm_storeu_si128((__m128i *) sum, acc);
+
+    uint32_t result = (uint32_t) sum[0] + sum[1] + sum[2] + sum[3];
+    for (; i < size; i++)
+        result += (uint32_t) in[i] * (uint32_t) seq[i];
+
+    return (int) result;
+}
+
+PK_TARGET("avx2")
+static int dotprod_ii_avx2(const int *seq, const int *in, size_t size)
+{
+    __m256i acc = _mm256_setzero_si256();
+
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i *) (in + i));
+        __m256i y = _mm256_loadu_si256((const __m256i *) (seq + i));
+        acc = _mm256_add_epi32(acc, _mm256_mullo_epi32(x, y));
+    }
+
+    int32_t sum[8];
+    _mm256_storeu_si256((__m256i *) sum, acc);
+
+    uint32_t result = 0;
+    size_t j;
+    for (j = 0; j < 8; j++)
+        result += (uint32_t) sum[j];
+
+    for (; i < size; i++)
+        result += (uint32_t) in[i] * (uint32_t) seq[i];
+
+    return (int) result;
+}
+
+PK_TARGET("avx512f")
+static int dotprod_ii_avx512(const int *seq, const int *in, size_t size)
+{
+    __m512i acc = _mm512_setzero_si512();
+
+    size_t i = 0;
+    for (; i < size; i += 16) {
+        __mmask16 mask = size - i >= 16 ? 0xffff : (__mmask16) ((1u << (size - i)) - 1);
+        __m512i x = _mm512_maskz_loadu_epi32(mask, in + i);
+        __m512i y = _mm512_maskz_loadu_epi32(mask, seq + i);
+        acc = _mm512_add_epi32(acc, _mm512_mullo_epi32(x, y));
+    }
+
+    return _mm512_reduce_add_epi32(acc);
+}
+
+/* Q15 fixed point */
+// products are widened to 32 bits before any of them are added, a pair
+// of -1 * -1 products already overflows int32, and summed in 64-bit
+// lanes. they narrow back to Q15 with rounding and saturation once at
+// the end, matching the scalar and NEON paths
+PK_TARGET("sse2")
+static int16_t dotprod_qq_sse2(const int16_t *seq, const int16_t *in, size_t size)
+{
+    __m128i acc0 = _mm_setzero_si128();
+    __m128i acc1 = _mm_setzero_si128();
+
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m128i x = _mm_loadu_si128((const __m128i *) (in + i));
+        __m128i y = _mm_loadu_si128((const __m128i *) (seq + i));
+        __m128i lo = _mm_mullo_epi16(x, y);
+        __m128i hi = _mm_mulhi_epi16(x, y);
+
+        __m128i p0 = _mm_unpacklo_epi16(lo, hi);
+        __m128i p1 = _mm_unpackhi_epi16(lo, hi);
+
+        // sign extend the 32-bit products into 64-bit lanes
+        __m128i s0 = _mm_srai_epi32(p0, 31);
+        __m128i s1 = _mm_srai_epi32(p1, 31);
+        acc0 = _mm_add_epi64(acc0, _mm_unpacklo_epi32(p0, s0));
+        acc1 = _mm_add_epi64(acc1, _mm_unpackhi_epi32(p0, s0));
+        acc0 = _mm_add_epi64(acc0, _mm_unpacklo_epi32(p1, s1));
+        acc1 = _mm_add_epi64(acc1, _mm_unpackhi_epi32(p1, s1));
+    }
+
+    int64_t sum[2];
+    _mm_storeu_si128((__m128i *) sum, _mm_add_epi64(acc0, acc1));
+
+    int64_t result = sum[0] + sum[1];
+    for (; i < size; i++)
+        result += in[i] * seq[i];
+
+    return pk_narrow_qq(result);
+}
+
+PK_TARGET("avx2")
+static int16_t dotprod_qq_avx2(const int16_t *seq, const int16_t *in, size_t size)
+{
+    __m256i acc0 = _mm256_setzero_si256();
+    __m256i acc1 = _mm256_setzero_si256();
+
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m256i x = _mm256_loadu_si256((const __m256i *) (in + i));
+        __m256i y = _mm256_loadu_si256((const __m256i *) (seq + i));
+        __m256i lo = _mm256_mullo_epi16(x, y);
+        __m256i hi = _mm256_mulhi_epi16(x, y);
+
+        // the order of the products doesn't matter for the sum
+        __m256i p0 = _mm256_unpacklo_epi16(lo, hi);
+        __m256i p1 = _mm256_unpackhi_epi16(lo, hi);
+
+        acc0 = _mm256_add_epi64(acc0, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(p0)));
+        acc1 = _mm256_add_epi64(acc1, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(p0, 1)));
+        acc0 = _mm256_add_epi64(acc0, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(p1)));
+        acc1 = _mm256_add_epi64(acc1, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(p1, 1)));
+    }
+
+    int64_t sum[4];
+    _mm256_storeu_si256((__m256i *) sum, _mm256_add_epi64(acc0, acc1));
+
+    int64_t result = (sum[0] + sum[1]) + (sum[2] + sum[3]);
+    for (; i < size; i++)
+        result += in[i] * seq[i];
+
+    return pk_narrow_qq(result);
+}
+
+#elif defined(PK_ARM_NEON)
+
+/* float */
+static float dotprod_ff_neon(const float *seq, const float *in, size_t size)
+{
+    float32x4_t acc0 = vdupq_n_f32(0);
+    float32x4_t acc1 = vdupq_n_f32(0);
+
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(in + i), vld1q_f32(seq + i));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(in + i + 4), vld1q_f32(seq + i + 4));
+    }
+
+    float sum[4];
+    vst1q_f32(sum, vaddq_f32(acc0, acc1));
+
+    float result = (sum[0] + sum[1]) + (sum[2] + sum[3]);
+    for (; i < size; i++)
+        result += in[i] * seq[i];
+
+    return result;
+}
+
+/* float complex */
+static float complex dotprod_cc_neon(const float complex *seq, const float complex *in, size_t size)
+{
+    const float *a = (const float *) in;
+    const float *b = (const float *) seq;
+
+    float32x4_t re = vdupq_n_f32(0);
+    float32x4_t im = vdupq_n_f32(0);
+
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        // deinterleave into real and imaginary rails
+        float32x4x2_t x = vld2q_f32(a + 2*i);
+        float32x4x2_t y = vld2q_f32(b + 2*i);
+
+        re = vmlaq_f32(re, x.val[0], y.val[0]);
+        re = vmlaq_f32(re, x.val[1], y.val[1]);
+        im = vmlaq_f32(im, x.val[1], y.val[0]);
+        im = vmlsq_f32(im, x.val[0], y.val[1]);
+    }
+
+    float r[4], s[4];
+    vst1q_f32(r, re);
+    vst1q_f32(s, im);
+
+    float complex result = ((r[0] + r[1]) + (r[2] + r[3]))
+                         + I * ((s[0] + s[1]) + (s[2] + s[3]));
+    for (; i < size; i++)
+        result += in[i] * conjf(seq[i]);
+
+    return result;
+}
+
+/* integers */
+static int dotprod_ii_neon(const int *seq, const int *in, size_t size)
+{
+    int32x4_t acc = vdupq_n_s32(0);
+
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4)
+        acc = vmlaq_s32(acc, vld1q_s32(in + i), vld1q_s32(seq + i));
+
+    int32_t sum[4];
+    vst1q_s32(sum, acc);
+
+    uint32_t result = (uint32_t) sum[0] + sum[1] + sum[2] + sum[3];
+    for (; i < size; i++)
+        result += (uint32_t) in[i] * (uint32_t) seq[i];
+
+    return (int) result;
+}
+
+/* Q15 fixed point */
+static int16_t dotprod_qq_neon(const int16_t *seq, const int16_t *in, size_t size)
+{
+    int64x2_t acc = vdupq_n_s64(0);
+
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        int16x8_t x = vld1q_s16(in + i);
+        int16x8_t y = vld1q_s16(seq + i);
+
+        // widening multiplies, pairwise accumulated into 64-bit lanes
+        acc = vpadalq_s32(acc, vmull_s16(vget_low_s16(x), vget_low_s16(y)));
+        acc = vpadalq_s32(acc, vmull_s16(vget_high_s16(x), vget_high_s16(y)));
+    }
+
+    int64_t result = vgetq_lane_s64(acc, 0) + vgetq_lane_s64(acc, 1);
+    for (; i < size; i++)
+        result += in[i] * seq[i];
+
+    return pk_narrow_qq(result);
+}
+
+#endif
+
+/* runtime kernel selection */
+int pk_isa_supported(pk_isa isa)
+{
+    switch (isa) {
+        case PK_ISA_SCALAR:
+            return 1;
+#if defined(PK_X86_SIMD)
+        case PK_ISA_SSE2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("sse2");
+        case PK_ISA_AVX2:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        case PK_ISA_AVX512:
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx512f");
+#elif defined(PK_ARM_NEON)
+        case PK_ISA_NEON:
+            return 1;
+#endif
+        default:
+            return 0;
+    }
+}
+
+pk_dotprod_ff_kernel pk_dotprod_ff_isa(pk_isa isa)
+{
+    if (!pk_isa_supported(isa))
+        return NULL;
+
+    switch (isa) {
+#if defined(PK_X86_SIMD)
+        case PK_ISA_SSE2:
+            return dotprod_ff_sse2;
+        case PK_ISA_AVX2:
+            return dotprod_ff_avx2;
+        case PK_ISA_AVX512:
+            return dotprod_ff_avx512;
+#elif defined(PK_ARM_NEON)
+        case PK_ISA_NEON:
+            return dotprod_ff_neon;
+#endif
+        default:
+            return NULL;
+    }
+}
+
+pk_dotprod_cc_kernel pk_dotprod_cc_isa(pk_isa isa)
+{
+    if (!pk_isa_supported(isa))
+        return NULL;
+
+    switch (isa) {
+#if defined(PK_X86_SIMD)
+        case PK_ISA_SSE2:
+            return dotprod_cc_sse2;
+        case PK_ISA_AVX2:
+            return dotprod_cc_avx2;
+        case PK_ISA_AVX512:
+            return dotprod_cc_avx512;
+#elif defined(PK_ARM_NEON)
+        case PK_ISA_NEON:
+            return dotprod_cc_neon;
+#endif
+        default:
+            return NULL;
+    }
+}
+
+// unsigned chars wrap around after a handful of products,
+// the scalar path is kept as is
+pk_dotprod_uu_kernel pk_dotprod_uu_isa(pk_isa isa)
+{
+    return NULL;
+}
+
+pk_dotprod_ii_kernel pk_dotprod_ii_isa(pk_isa isa)
+{
+    if (!pk_isa_supported(isa))
+        return NULL;
+
+    switch (isa) {
+#if defined(PK_X86_SIMD)
+        case PK_ISA_SSE2:
+            return dotprod_ii_sse2;
+        case PK_ISA_AVX2:
+            return dotprod_ii_avx2;
+        case PK_ISA_AVX512:
+            return dotprod_ii_avx512;
+#elif defined(PK_ARM_NEON)
+        case PK_ISA_NEON:
+            return dotprod_ii_neon;
+#endif
+        default:
+            return NULL;
+    }
+}
+
+pk_dotprod_qq_kernel pk_dotprod_qq_isa(pk_isa isa)
+{
+    if (!pk_isa_supported(isa))
+        return NULL;
+
+    switch (isa) {
+#if defined(PK_X86_SIMD)
+        case PK_ISA_SSE2:
+            return dotprod_qq_sse2;
+        case PK_ISA_AVX2:
+            return dotprod_qq_avx2;
+#elif defined(PK_ARM_NEON)
+        case PK_ISA_NEON:
+            return dotprod_qq_neon;
+#endif
+        default:
+            return NULL;
+    }
+}
+
+// vector instruction sets from the most to the least preferred
+static const pk_isa dotprod_isa_order[] = {
+    PK_ISA_AVX512, PK_ISA_AVX2, PK_ISA_SSE2, PK_ISA_NEON
+};
+
+#define DOTPROD_ISA_COUNT (sizeof(dotprod_isa_order) / sizeof(dotprod_isa_order[0]))
+
+pk_dotprod_ff_kernel pk_dotprod_ff_select(void)
+{
+    pk_dotprod_ff_kernel kernel = NULL;
+
+    size_t i;
+    for (i = 0; i < DOTPROD_ISA_COUNT && kernel == NULL; i++)
+        kernel = pk_dotprod_ff_isa(dotprod_isa_order[i]);
+
+    return kernel;
+}
+
+pk_dotprod_cc_kernel pk_dotprod_cc_select(void)
+{
+    pk_dotprod_cc_kernel kernel = NULL;
+
+    size_t i;
+    for (i = 0; i < DOTPROD_ISA_COUNT && kernel == NULL; i++)
+        kernel = pk_dotprod_cc_isa(dotprod_isa_order[i]);
+
+    return kernel;
+}
+
+pk_dotprod_uu_kernel pk_dotprod_uu_select(void)
+{
+    return NULL;
+}
+
+pk_dotprod_ii_kernel pk_dotprod_ii_select(void)
+{
+    pk_dotprod_ii_kernel kernel = NULL;
+
+    size_t i;
+    for (i = 0; i < DOTPROD_ISA_COUNT && kernel == NULL; i++)
+        kernel = pk_dotprod_ii_isa(dotprod_isa_order[i]);
+
+    return kernel;
+}
+
+pk_dotprod_qq_kernel pk_dotprod_qq_select(void)
+{
+    pk_dotprod_qq_kernel kernel = NULL;
+
+    size_t i;
+    for (i = 0; i < DOTPROD_ISA_COUNT && kernel == NULL; i++)
+        kernel = pk_dotprod_qq_isa(dotprod_isa_order[i]);
+
+    return kernel;
+}
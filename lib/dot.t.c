@@ -25,22 +25,41 @@
 #include "plancki.h"
 
 /* dot product objects */
-// simple dot product
-// TODO: include SIMD intrinsics
+// the kernel is chosen once at creation based on the
+// vector extensions of the running cpu
 typedef struct pk_dotprod_XX_s
 {
     <O> *seq;
     size_t size;
+    pk_dotprod_XX_kernel kernel;
 } pk_dotprod_XX;
 
+// portable scalar kernel
+static <O> dotprod_XX_scalar(const <O> *seq, const <I> *in, size_t size)
+{
+    pk_acc_XX result = 0;
+
+    unsigned int i;
+    for (i = 0; i < size; i++)
+        result += pk_mulconj_XX(in[i], seq[i]);
+
+    return pk_narrow_XX(result);
+}
+
 pk_dotprod_XX *pk_dotprod_XX_create(const <O> *seq, size_t size)
 {
-    pk_dotprod_XX *dp = malloc(sizeof(pk_dotprod_XX));
+    pk_dotprod_XX *dp = pk_malloc(sizeof(pk_dotprod_XX));
 
     dp->size = size;
-    dp->seq = malloc(size * sizeof(<O>));
+    dp->seq = pk_malloc(size * sizeof(<O>));
 
     memcpy(dp->seq, seq, size * sizeof(<O>));
+
+    dp->kernel = pk_dotprod_XX_select();
+    if (dp->kernel == NULL)
+        dp->kernel = dotprod_XX_scalar;
+
+    return dp;
 }
 
 void pk_dotprod_XX_load(pk_dotprod_XX *dp, const <O> *seq, size_t size)
@@ -48,19 +67,28 @@ void pk_dotprod_XX_load(pk_dotprod_XX *dp, const <O> *seq, size_t size)
     memcpy(dp->seq, seq, size * sizeof(<O>));
 }
 
-<O> pk_dotprod_XX_execute(pk_dotprod_XX *dp, const <I> *in, size_t size)
+int pk_dotprod_XX_set_isa(pk_dotprod_XX *dp, pk_isa isa)
 {
-    <O> result = 0;
+    if (isa == PK_ISA_SCALAR) {
+        dp->kernel = dotprod_XX_scalar;
+        return 1;
+    }
 
-    unsigned int i;
-    for (i = 0; i < size; i++)
-        result += (in[i] * conj(dp->seq[i]));
+    pk_dotprod_XX_kernel kernel = pk_dotprod_XX_isa(isa);
+    if (kernel == NULL)
+        return 0;
 
-    return result;
+    dp->kernel = kernel;
+    return 1;
+}
+
+<O> pk_dotprod_XX_execute(pk_dotprod_XX *dp, const <I> *in, size_t size)
+{
+    return dp->kernel(dp->seq, in, size);
 }
 
 void pk_dotprod_XX_destroy(pk_dotprod_XX *dp)
 {
-    free(dp->seq);
-    free(dp);
+    pk_free(dp->seq);
+    pk_free(dp);
 }
@@ -24,26 +24,761 @@
 
 #include "plancki.h"
 
+#include <string.h>
+
+#if defined(PK_X86_SIMD)
+#include <immintrin.h>
+#endif
+
 /* CRC and error detection routines */
 // Algorithm comes from Kenneth W. Finnegan's APRS thesis.
-// This particular CRC function is appropriate for AX.25
+// This particular CRC function is appropriate for AX.25,
+// the bitwise loop is unrolled into a byte table on poly 0x8408
+static const uint16_t crc_ax25_tab[256] = {
+    0x0000, 0x1189, 0x2312, 0x329b, 0x4624, 0x57ad, 0x6536, 0x74bf,
+    0x8c48, 0x9dc1, 0xaf5a, 0xbed3, 0xca6c, 0xdbe5, 0xe97e, 0xf8f7,
+    0x1081, 0x0108, 0x3393, 0x221a, 0x56a5, 0x472c, 0x75b7, 0x643e,
+    0x9cc9, 0x8d40, 0xbfdb, 0xae52, 0xdaed, 0xcb64, 0xf9ff, 0xe876,
+    0x2102, 0x308b, 0x0210, 0x1399, 0x6726, 0x76af, 0x4434, 0x55bd,
+    0xad4a, 0xbcc3, 0x8e58, 0x9fd1, 0xeb6e, 0xfae7, 0xc87c, 0xd9f5,
+    0x3183, 0x200a, 0x1291, 0x0318, 0x77a7, 0x662e, 0x54b5, 0x453c,
+    0xbdcb, 0xac42, 0x9ed9, 0x8f50, 0xfbef, 0xea66, 0xd8fd, 0xc974,
+    0x4204, 0x538d, 0x6116, 0x709f, 0x0420, 0x15a9, 0x2732, 0x36bb,
+    0xce4c, 0xdfc5, 0xed5e, 0xfcd7, 0x8868, 0x99e1, 0xab7a, 0xbaf3,
+    0x5285, 0x430c, 0x7197, 0x601e, 0x14a1, 0x0528, 0x37b3, 0x263a,
+    0xdecd, 0xcf44, 0xfddf, 0xec56, 0x98e9, 0x8960, 0xbbfb, 0xaa72,
+    0x6306, 0x728f, 0x4014, 0x519d, 0x2522, 0x34ab, 0x0630, 0x17b9,
+    0xef4e, 0xfec7, 0xcc5c, 0xddd5, 0xa96a, 0xb8e3, 0x8a78, 0x9bf1,
+    0x7387, 0x620e, 0x5095, 0x411c, 0x35a3, 0x242a, 0x16b1, 0x0738,
+    0xffcf, 0xee46, 0xdcdd, 0xcd54, 0xb9eb, 0xa862, 0x9af9, 0x8b70,
+    0x8408, 0x9581, 0xa71a, 0xb693, 0xc22c, 0xd3a5, 0xe13e, 0xf0b7,
+    0x0840, 0x19c9, 0x2b52, 0x3adb, 0x4e64, 0x5fed, 0x6d76, 0x7cff,
+    0x9489, 0x8500, 0xb79b, 0xa612, 0xd2ad, 0xc324, 0xf1bf, 0xe036,
+    0x18c1, 0x0948, 0x3bd3, 0x2a5a, 0x5ee5, 0x4f6c, 0x7df7, 0x6c7e,
+    0xa50a, 0xb483, 0x8618, 0x9791, 0xe32e, 0xf2a7, 0xc03c, 0xd1b5,
+    0x2942, 0x38cb, 0x0a50, 0x1bd9, 0x6f66, 0x7eef, 0x4c74, 0x5dfd,
+    0xb58b, 0xa402, 0x9699, 0x8710, 0xf3af, 0xe226, 0xd0bd, 0xc134,
+    0x39c3, 0x284a, 0x1ad1, 0x0b58, 0x7fe7, 0x6e6e, 0x5cf5, 0x4d7c,
+    0xc60c, 0xd785, 0xe51e, 0xf497, 0x8028, 0x91a1, 0xa33a, 0xb2b3,
+    0x4a44, 0x5bcd, 0x6956, 0x78df, 0x0c60, 0x1de9, 0x2f72, 0x3efb,
+    0xd68d, 0xc704, 0xf59f, 0xe416, 0x90a9, 0x8120, 0xb3bb, 0xa232,
+    0x5ac5, 0x4b4c, 0x79d7, 0x685e, 0x1ce1, 0x0d68, 0x3ff3, 0x2e7a,
+    0xe70e, 0xf687, 0xc41c, 0xd595, 0xa12a, 0xb0a3, 0x8238, 0x93b1,
+    0x6b46, 0x7acf, 0x4854, 0x59dd, 0x2d62, 0x3ceb, 0x0e70, 0x1ff9,
+    0xf78f, 0xe606, 0xd49d, 0xc514, 0xb1ab, 0xa022, 0x92b9, 0x8330,
+    0x7bc7, 0x6a4e, 0x58d5, 0x495c, 0x3de3, 0x2c6a, 0x1ef1, 0x0f78,
+};
+
 unsigned int crc_ax25_byte(const unsigned char *data, size_t size)
 {
     unsigned int crc = 0xffff;
-    unsigned int mask = 0;
-
-    unsigned char byte = 0;
-    unsigned char bit  = 0;
-
-    size_t i, j;
-    for (i = 0; i < size; i++) {
-        byte = data[i];
-        for (j = 0; j < 8; j++) {
-            bit = (byte >> j) & 1;
-            mask = 0x8408 & -((crc & 1) ^ bit);
-            crc = (crc >> 1) ^ mask;
+
+    size_t i;
+    for (i = 0; i < size; i++)
+        crc = (crc >> 8) ^ crc_ax25_tab[(crc ^ data[i]) & 0xff];
+
+    return crc;
+}
+
+/* Parameterized CRC engine */
+// reflected registers hold the next bit to leave in the lsb, which
+// works for any width with the reflected polynomial. normal registers
+// are kept left aligned in 32 bits so every width shares one loop
+#define CRC_SLICES      8
+
+// inputs shorter than this skip the carry-less multiply setup
+#define CRC_CLMUL_MIN   64
+
+typedef uint32_t (*crc_kernel)(const pk_crc *c, uint32_t reg, const unsigned char *data, size_t size);
+
+typedef struct pk_crc_s
+{
+    unsigned int width;
+    int reflect;
+    uint32_t poly;
+    uint32_t init;
+    uint32_t xorout;
+
+    uint32_t table[CRC_SLICES][256];
+
+    // folding constants and kernel for reflected registers
+    uint64_t fold_lo;
+    uint64_t fold_hi;
+    crc_kernel clmul;
+} pk_crc;
+
+static uint32_t crc_reflect(uint32_t x, unsigned int bits)
+{
+    uint32_t r = 0;
+
+    unsigned int i;
+    for (i = 0; i < bits; i++) {
+        r = (r << 1) | (x & 1);
+        x >>= 1;
+    }
+
+    return r;
+}
+
+static uint32_t crc_load_le(const unsigned char *p)
+{
+    return (uint32_t) p[0] | (uint32_t) p[1] << 8 | (uint32_t) p[2] << 16 | (uint32_t) p[3] << 24;
+}
+
+static uint32_t crc_load_be(const unsigned char *p)
+{
+    return (uint32_t) p[0] << 24 | (uint32_t) p[1] << 16 | (uint32_t) p[2] << 8 | (uint32_t) p[3];
+}
+
+// slice-by-8, each table advances a byte through one more byte of zeros
+static uint32_t crc_update_reflected(const pk_crc *c, uint32_t reg, const unsigned char *data, size_t size)
+{
+    const uint32_t (*t)[256] = c->table;
+
+    for (; size >= 8; size -= 8, data += 8) {
+        uint32_t a = reg ^ crc_load_le(data);
+        uint32_t b = crc_load_le(data + 4);
+
+        reg = t[7][a & 0xff] ^ t[6][(a >> 8) & 0xff] ^ t[5][(a >> 16) & 0xff] ^ t[4][a >> 24]
+            ^ t[3][b & 0xff] ^ t[2][(b >> 8) & 0xff] ^ t[1][(b >> 16) & 0xff] ^ t[0][b >> 24];
+    }
+
+    for (; size > 0; size--)
+        reg = (reg >> 8) ^ t[0][(reg ^ *data++) & 0xff];
+
+    return reg;
+}
+
+static uint32_t crc_update_normal(const pk_crc *c, uint32_t reg, const unsigned char *data, size_t size)
+{
+    const uint32_t (*t)[256] = c->table;
+
+    for (; size >= 8; size -= 8, data += 8) {
+        uint32_t a = reg ^ crc_load_be(data);
+        uint32_t b = crc_load_be(data + 4);
+
+        reg = t[7][a >> 24] ^ t[6][(a >> 16) & 0xff] ^ t[5][(a >> 8) & 0xff] ^ t[4][a & 0xff]
+            ^ t[3][b >> 24] ^ t[2][(b >> 16) & 0xff] ^ t[1][(b >> 8) & 0xff] ^ t[0][b & 0xff];
+    }
+
+    for (; size > 0; size--)
+        reg = (reg << 8) ^ t[0][(reg >> 24) ^ *data++];
+
+    return reg;
+}
+
+// x^n mod P for the full width polynomial, in normal bit order
+static uint32_t crc_xpow_mod(const pk_crc *c, unsigned int n)
+{
+    uint64_t top = (uint64_t) 1 << c->width;
+    uint64_t r = 1;
+
+    unsigned int i;
+    for (i = 0; i < n; i++) {
+        r <<= 1;
+        if (r & top)
+            r ^= top | c->poly;
+    }
+
+    return (uint32_t) r;
+}
+
+#if defined(PK_X86_SIMD)
+// folds 16 bytes at a time, a 128 bit block a followed by 16 more bytes
+// is congruent to a * x^128, so the first half of a is multiplied by
+// x^192 and the second by x^128 mod P. in reflected order a carry-less
+// product comes out one bit short, which the constants absorb as x^191
+// and x^127. the init register is xored into the message up front and
+// the folded block is finished on the tables with a zero register
+PK_TARGET("pclmul,sse2")
+static uint32_t crc_update_clmul(const pk_crc *c, uint32_t reg, const unsigned char *data, size_t size)
+{
+    const __m128i k = _mm_set_epi64x((long long) c->fold_hi, (long long) c->fold_lo);
+
+    __m128i acc = _mm_loadu_si128((const __m128i *) data);
+    acc = _mm_xor_si128(acc, _mm_cvtsi32_si128((int) reg));
+    data += 16;
+    size -= 16;
+
+    for (; size >= 16; size -= 16, data += 16) {
+        __m128i lo = _mm_clmulepi64_si128(acc, k, 0x00);
+        __m128i hi = _mm_clmulepi64_si128(acc, k, 0x11);
+        acc = _mm_xor_si128(_mm_xor_si128(lo, hi), _mm_loadu_si128((const __m128i *) data));
+    }
+
+    unsigned char block[16];
+    _mm_storeu_si128((__m128i *) block, acc);
+
+    reg = crc_update_reflected(c, 0, block, 16);
+    return crc_update_reflected(c, reg, data, size);
+}
+#endif
+
+static crc_kernel crc_clmul_select(void)
+{
+#if defined(PK_X86_SIMD)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("pclmul"))
+        return crc_update_clmul;
+#endif
+    return NULL;
+}
+
+// create a CRC of width bits between 8 and 32. poly, init and xorout
+// are given in normal bit order, reflect processes bytes lsb first
+// and reflects the result as most serial link CRCs do
+pk_crc *pk_crc_create(
+    unsigned int width,
+    uint32_t poly,
+    int reflect,
+    uint32_t init,
+    uint32_t xorout)
+{
+    if (width < 8 || width > 32) {
+        fprintf(stderr, "CRC width must be between 8 and 32 bits.\n");
+        exit(1);
+    }
+
+    uint32_t mask = width == 32 ? 0xffffffff : (1u << width) - 1;
+
+    pk_crc *c = pk_malloc(sizeof(pk_crc));
+    c->width = width;
+    c->reflect = reflect;
+    c->poly = poly & mask;
+    c->init = init & mask;
+    c->xorout = xorout & mask;
+    c->clmul = NULL;
+
+    size_t i, s;
+    if (reflect) {
+        uint32_t rpoly = crc_reflect(c->poly, width);
+
+        for (i = 0; i < 256; i++) {
+            uint32_t r = i;
+            for (s = 0; s < 8; s++)
+                r = (r >> 1) ^ (rpoly & -(r & 1));
+            c->table[0][i] = r;
         }
+
+        for (s = 1; s < CRC_SLICES; s++)
+            for (i = 0; i < 256; i++)
+                c->table[s][i] = (c->table[s-1][i] >> 8) ^ c->table[0][c->table[s-1][i] & 0xff];
+
+        // constants hold x^n mod P reflected across 64 bits
+        c->fold_lo = (uint64_t) crc_reflect(crc_xpow_mod(c, 191), 32) << 32;
+        c->fold_hi = (uint64_t) crc_reflect(crc_xpow_mod(c, 127), 32) << 32;
+        c->clmul = crc_clmul_select();
+    } else {
+        uint32_t apoly = c->poly << (32 - width);
+
+        for (i = 0; i < 256; i++) {
+            uint32_t r = (uint32_t) i << 24;
+            for (s = 0; s < 8; s++)
+                r = (r << 1) ^ (apoly & -(r >> 31));
+            c->table[0][i] = r;
+        }
+
+        for (s = 1; s < CRC_SLICES; s++)
+            for (i = 0; i < 256; i++)
+                c->table[s][i] = (c->table[s-1][i] << 8) ^ c->table[0][c->table[s-1][i] >> 24];
     }
 
-    return crc;
+    return c;
+}
+
+pk_crc *pk_crc_create_preset(pk_crc_preset preset)
+{
+    switch (preset) {
+        case PK_CRC_AX25:
+            return pk_crc_create(16, 0x1021, 1, 0xffff, 0xffff);
+        case PK_CRC_16_CCITT:
+            return pk_crc_create(16, 0x1021, 0, 0xffff, 0x0000);
+        case PK_CRC_32:
+            return pk_crc_create(32, 0x04c11db7, 1, 0xffffffff, 0xffffffff);
+    }
+
+    fprintf(stderr, "Unknown CRC preset.\n");
+    exit(1);
+}
+
+uint32_t pk_crc_init(pk_crc *c)
+{
+    return c->reflect ? crc_reflect(c->init, c->width) : c->init;
+}
+
+uint32_t pk_crc_update(pk_crc *c, uint32_t reg, const unsigned char *data, size_t size)
+{
+    if (!c->reflect) {
+        reg = crc_update_normal(c, reg << (32 - c->width), data, size);
+        return reg >> (32 - c->width);
+    }
+
+    if (c->clmul != NULL && size >= CRC_CLMUL_MIN)
+        return c->clmul(c, reg, data, size);
+
+    return crc_update_reflected(c, reg, data, size);
+}
+
+uint32_t pk_crc_final(pk_crc *c, uint32_t reg)
+{
+    return reg ^ c->xorout;
+}
+
+uint32_t pk_crc_compute(pk_crc *c, const unsigned char *data, size_t size)
+{
+    return pk_crc_final(c, pk_crc_update(c, pk_crc_init(c), data, size));
+}
+
+void pk_crc_destroy(pk_crc *c)
+{
+    pk_free(c);
+}
+
+/* Convolutional code, K = 7 r = 1/2 as used by CCSDS */
+// generators 0171 and 0133 with the newest bit on the left, the second
+// output is inverted. the register keeps the newest bit in the lsb so
+// the taps read reversed
+#define CONV_K          7
+#define CONV_STATES     (1 << (CONV_K - 1))
+#define CONV_POLY_A     0x4f
+#define CONV_POLY_B     0x6d
+
+static unsigned int conv_parity(unsigned int x)
+{
+    x ^= x >> 4;
+    x ^= x >> 2;
+    x ^= x >> 1;
+    return x & 1;
+}
+
+typedef struct pk_convenc_s
+{
+    unsigned int state;
+    pk_block_uu *data;
+} pk_convenc;
+
+pk_convenc *pk_convenc_create(void)
+{
+    pk_convenc *enc = pk_malloc(sizeof(pk_convenc));
+    enc->state = 0;
+    enc->data = pk_block_uu_create(256);
+
+    return enc;
+}
+
+void pk_convenc_process(pk_convenc *enc, const unsigned char *bits, size_t num)
+{
+    pk_block_uu_clear(enc->data);
+    unsigned char *out = pk_block_uu_begin_write(enc->data, 2 * num);
+
+    size_t i;
+    for (i = 0; i < num; i++) {
+        enc->state = ((enc->state << 1) | (bits[i] & 1)) & 0x7f;
+        out[2*i] = conv_parity(enc->state & CONV_POLY_A);
+        out[2*i + 1] = conv_parity(enc->state & CONV_POLY_B) ^ 1;
+    }
+
+    pk_block_uu_commit(enc->data, 2 * num);
+}
+
+unsigned char *pk_convenc_read(pk_convenc *enc, size_t *nitems)
+{
+    *nitems = pk_block_uu_nitems(enc->data);
+    return pk_block_uu_ptr(enc->data);
+}
+
+void pk_convenc_reset(pk_convenc *enc)
+{
+    enc->state = 0;
+}
+
+void pk_convenc_destroy(pk_convenc *enc)
+{
+    pk_block_uu_destroy(enc->data);
+    pk_free(enc);
+}
+
+/* Viterbi decoder */
+// states are the last six input bits, newest in the lsb. states j and
+// j + 32 both lead to 2j and 2j + 1, and as every tap covers the newest
+// and oldest bits the four branches only take a metric m or its
+// complement 510 - m. path metrics are 16 bit and renormalized to state
+// zero after every step, they never spread by more than six branches.
+//
+// a decision word per step marks the states whose survivor came from
+// the upper predecessor. once VITERBI_STEPS are stored the oldest
+// VITERBI_CHUNK are traced back from the best state and the newest
+// VITERBI_DEPTH are kept for the next traceback
+#define VITERBI_DEPTH   64
+#define VITERBI_CHUNK   192
+#define VITERBI_STEPS   (VITERBI_DEPTH + VITERBI_CHUNK)
+#define VITERBI_MAX     510
+
+// runs num steps over 2 * num soft symbols
+typedef void (*viterbi_kernel)(
+    int16_t *metrics,
+    const int16_t *expect_a,
+    const int16_t *expect_b,
+    const unsigned char *soft,
+    uint64_t *decisions,
+    size_t num);
+
+typedef struct pk_viterbi_s
+{
+    // expected symbols of the branch from j to 2j, 0 or 255
+    int16_t expect_a[CONV_STATES / 2];
+    int16_t expect_b[CONV_STATES / 2];
+
+    int16_t metrics[CONV_STATES];
+    uint64_t decisions[VITERBI_STEPS];
+    size_t steps;
+
+    // a soft symbol waiting for its pair
+    unsigned char pending;
+    int has_pending;
+
+    viterbi_kernel acs;
+    pk_block_uu *data;
+} pk_viterbi;
+
+static void viterbi_acs_scalar(
+    int16_t *metrics,
+    const int16_t *expect_a,
+    const int16_t *expect_b,
+    const unsigned char *soft,
+    uint64_t *decisions,
+    size_t num)
+{
+    int16_t next[CONV_STATES];
+
+    size_t i;
+    for (i = 0; i < num; i++) {
+        uint64_t d = 0;
+
+        unsigned int j;
+        for (j = 0; j < CONV_STATES / 2; j++) {
+            int m = (soft[2*i] ^ expect_a[j]) + (soft[2*i + 1] ^ expect_b[j]);
+            int lo = metrics[j];
+            int hi = metrics[j + CONV_STATES / 2];
+
+            int even_lo = lo + m, even_hi = hi + VITERBI_MAX - m;
+            int odd_lo = lo + VITERBI_MAX - m, odd_hi = hi + m;
+
+            next[2*j] = even_hi < even_lo ? even_hi : even_lo;
+            next[2*j + 1] = odd_hi < odd_lo ? odd_hi : odd_lo;
+            d |= (uint64_t) (even_hi < even_lo) << (2*j);
+            d |= (uint64_t) (odd_hi < odd_lo) << (2*j + 1);
+        }
+
+        int16_t base = next[0];
+        for (j = 0; j < CONV_STATES; j++)
+            metrics[j] = next[j] - base;
+
+        decisions[i] = d;
+    }
+}
+
+#if defined(PK_X86_SIMD)
+// eight butterflies per vector, the even and odd results are
+// interleaved back into state order
+PK_TARGET("sse2")
+static void viterbi_acs_sse2(
+    int16_t *metrics,
+    const int16_t *expect_a,
+    const int16_t *expect_b,
+    const unsigned char *soft,
+    uint64_t *decisions,
+    size_t num)
+{
+    const __m128i max = _mm_set1_epi16(VITERBI_MAX);
+
+    __m128i m[8], ea[4], eb[4];
+
+    unsigned int k;
+    for (k = 0; k < 8; k++)
+        m[k] = _mm_loadu_si128((const __m128i *) (metrics + 8*k));
+    for (k = 0; k < 4; k++) {
+        ea[k] = _mm_loadu_si128((const __m128i *) (expect_a + 8*k));
+        eb[k] = _mm_loadu_si128((const __m128i *) (expect_b + 8*k));
+    }
+
+    size_t i;
+    for (i = 0; i < num; i++) {
+        const __m128i sa = _mm_set1_epi16(soft[2*i]);
+        const __m128i sb = _mm_set1_epi16(soft[2*i + 1]);
+
+        __m128i n[8];
+        uint64_t d = 0;
+
+        for (k = 0; k < 4; k++) {
+            __m128i bm = _mm_add_epi16(_mm_xor_si128(sa, ea[k]), _mm_xor_si128(sb, eb[k]));
+            __m128i bmc = _mm_sub_epi16(max, bm);
+
+            __m128i even_lo = _mm_add_epi16(m[k], bm);
+            __m128i even_hi = _mm_add_epi16(m[k + 4], bmc);
+            __m128i odd_lo = _mm_add_epi16(m[k], bmc);
+            __m128i odd_hi = _mm_add_epi16(m[k + 4], bm);
+
+            __m128i even = _mm_min_epi16(even_lo, even_hi);
+            __m128i odd = _mm_min_epi16(odd_lo, odd_hi);
+            __m128i even_d = _mm_cmpgt_epi16(even_lo, even_hi);
+            __m128i odd_d = _mm_cmpgt_epi16(odd_lo, odd_hi);
+
+            n[2*k] = _mm_unpacklo_epi16(even, odd);
+            n[2*k + 1] = _mm_unpackhi_epi16(even, odd);
+
+            __m128i dec = _mm_packs_epi16(_mm_unpacklo_epi16(even_d, odd_d),
+                                          _mm_unpackhi_epi16(even_d, odd_d));
+            d |= (uint64_t) (unsigned int) _mm_movemask_epi8(dec) << (16*k);
+        }
+
+        const __m128i base = _mm_set1_epi16((int16_t) _mm_cvtsi128_si32(n[0]));
+        for (k = 0; k < 8; k++)
+            m[k] = _mm_sub_epi16(n[k], base);
+
+        decisions[i] = d;
+    }
+
+    for (k = 0; k < 8; k++)
+        _mm_storeu_si128((__m128i *) (metrics + 8*k), m[k]);
+}
+
+// sixteen butterflies per vector, unpacking works within 128 bit lanes
+// so the halves are swapped back into state order
+PK_TARGET("avx2")
+static void viterbi_acs_avx2(
+    int16_t *metrics,
+    const int16_t *expect_a,
+    const int16_t *expect_b,
+    const unsigned char *soft,
+    uint64_t *decisions,
+    size_t num)
+{
+    const __m256i max = _mm256_set1_epi16(VITERBI_MAX);
+
+    __m256i m[4], ea[2], eb[2];
+
+    unsigned int k;
+    for (k = 0; k < 4; k++)
+        m[k] = _mm256_loadu_si256((const __m256i *) (metrics + 16*k));
+    for (k = 0; k < 2; k++) {
+        ea[k] = _mm256_loadu_si256((const __m256i *) (expect_a + 16*k));
+        eb[k] = _mm256_loadu_si256((const __m256i *) (expect_b + 16*k));
+    }
+
+    size_t i;
+    for (i = 0; i < num; i++) {
+        const __m256i sa = _mm256_set1_epi16(soft[2*i]);
+        const __m256i sb = _mm256_set1_epi16(soft[2*i + 1]);
+
+        __m256i n[4];
+        uint64_t d = 0;
+
+        for (k = 0; k < 2; k++) {
+            __m256i bm = _mm256_add_epi16(_mm256_xor_si256(sa, ea[k]), _mm256_xor_si256(sb, eb[k]));
+            __m256i bmc = _mm256_sub_epi16(max, bm);
+
+            __m256i even_lo = _mm256_add_epi16(m[k], bm);
+            __m256i even_hi = _mm256_add_epi16(m[k + 2], bmc);
+            __m256i odd_lo = _mm256_add_epi16(m[k], bmc);
+            __m256i odd_hi = _mm256_add_epi16(m[k + 2], bm);
+
+            __m256i even = _mm256_min_epi16(even_lo, even_hi);
+            __m256i odd = _mm256_min_epi16(odd_lo, odd_hi);
+            __m256i even_d = _mm256_cmpgt_epi16(even_lo, even_hi);
+            __m256i odd_d = _mm256_cmpgt_epi16(odd_lo, odd_hi);
+
+            __m256i lo = _mm256_unpacklo_epi16(even, odd);
+            __m256i hi = _mm256_unpackhi_epi16(even, odd);
+            n[2*k] = _mm256_permute2x128_si256(lo, hi, 0x20);
+            n[2*k + 1] = _mm256_permute2x128_si256(lo, hi, 0x31);
+
+            __m256i dlo = _mm256_unpacklo_epi16(even_d, odd_d);
+            __m256i dhi = _mm256_unpackhi_epi16(even_d, odd_d);
+            __m256i dec = _mm256_packs_epi16(_mm256_permute2x128_si256(dlo, dhi, 0x20),
+                                             _mm256_permute2x128_si256(dlo, dhi, 0x31));
+            dec = _mm256_permute4x64_epi64(dec, 0xd8);
+            d |= (uint64_t) (uint32_t) _mm256_movemask_epi8(dec) << (32*k);
+        }
+
+        const __m256i base = _mm256_broadcastw_epi16(_mm256_castsi256_si128(n[0]));
+        for (k = 0; k < 4; k++)
+            m[k] = _mm256_sub_epi16(n[k], base);
+
+        decisions[i] = d;
+    }
+
+    for (k = 0; k < 4; k++)
+        _mm256_storeu_si256((__m256i *) (metrics + 16*k), m[k]);
+}
+#endif
+
+static viterbi_kernel viterbi_select(void)
+{
+#if defined(PK_X86_SIMD)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return viterbi_acs_avx2;
+    if (__builtin_cpu_supports("sse2"))
+        return viterbi_acs_sse2;
+#endif
+    return viterbi_acs_scalar;
+}
+
+// create a soft decision decoder for the K = 7 r = 1/2 CCSDS code
+pk_viterbi *pk_viterbi_create(void)
+{
+    pk_viterbi *v = pk_malloc(sizeof(pk_viterbi));
+
+    unsigned int j;
+    for (j = 0; j < CONV_STATES / 2; j++) {
+        v->expect_a[j] = conv_parity((2*j) & CONV_POLY_A) ? 255 : 0;
+        v->expect_b[j] = conv_parity((2*j) & CONV_POLY_B) ? 0 : 255;
+    }
+
+    v->acs = viterbi_select();
+    v->data = pk_block_uu_create(VITERBI_STEPS);
+    pk_viterbi_reset(v);
+
+    return v;
+}
+
+// start from the all zero state the encoder begins in
+void pk_viterbi_reset(pk_viterbi *v)
+{
+    unsigned int j;
+    for (j = 0; j < CONV_STATES; j++)
+        v->metrics[j] = j == 0 ? 0 : 2 * VITERBI_MAX;
+
+    v->steps = 0;
+    v->has_pending = 0;
+}
+
+static unsigned int viterbi_best_state(pk_viterbi *v)
+{
+    unsigned int state = 0;
+
+    unsigned int j;
+    for (j = 1; j < CONV_STATES; j++) {
+        if (v->metrics[j] < v->metrics[state])
+            state = j;
+    }
+
+    return state;
+}
+
+// trace back from state over all stored steps and output
+// the bits of the oldest num of them
+static void viterbi_traceback(pk_viterbi *v, unsigned int state, size_t num)
+{
+    unsigned char *out = pk_block_uu_begin_write(v->data, num);
+
+    size_t t;
+    for (t = v->steps; t > 0; t--) {
+        if (t <= num)
+            out[t - 1] = state & 1;
+
+        unsigned int d = (v->decisions[t - 1] >> state) & 1;
+        state = (state >> 1) | (d << (CONV_K - 2));
+    }
+
+    pk_block_uu_commit(v->data, num);
+
+    memmove(v->decisions, v->decisions + num, (v->steps - num) * sizeof(uint64_t));
+    v->steps -= num;
+}
+
+static void viterbi_run(pk_viterbi *v, const unsigned char *soft, size_t num)
+{
+    while (num > 0) {
+        size_t room = VITERBI_STEPS - v->steps;
+        size_t n = num < room ? num : room;
+
+        v->acs(v->metrics, v->expect_a, v->expect_b, soft, v->decisions + v->steps, n);
+        v->steps += n;
+        soft += 2 * n;
+        num -= n;
+
+        if (v->steps == VITERBI_STEPS)
+            viterbi_traceback(v, viterbi_best_state(v), VITERBI_CHUNK);
+    }
+}
+
+// decode soft symbols, 0 is a confident 0 and 255 a confident 1. bits
+// come out VITERBI_DEPTH to VITERBI_STEPS symbol pairs later
+void pk_viterbi_process(pk_viterbi *v, const unsigned char *soft, size_t num)
+{
+    pk_block_uu_clear(v->data);
+
+    if (num == 0)
+        return;
+
+    if (v->has_pending) {
+        unsigned char pair[2] = {v->pending, soft[0]};
+        viterbi_run(v, pair, 1);
+        soft++;
+        num--;
+        v->has_pending = 0;
+    }
+
+    viterbi_run(v, soft, num / 2);
+
+    if (num % 2) {
+        v->pending = soft[num - 1];
+        v->has_pending = 1;
+    }
+}
+
+// output every stored bit, for the end of a transmission. the last
+// few bits are only as good as the best state's guess
+// the decoder is reset once the last bits are out, so an unpaired
+// symbol or the old metrics can't leak into the next stream
+void pk_viterbi_flush(pk_viterbi *v)
+{
+    pk_block_uu_clear(v->data);
+    viterbi_traceback(v, viterbi_best_state(v), v->steps);
+    pk_viterbi_reset(v);
+}
+
+// output every stored bit of a stream the encoder ended with
+// K - 1 zero bits, which leaves it in the all zero state
+void pk_viterbi_terminate(pk_viterbi *v)
+{
+    pk_block_uu_clear(v->data);
+    viterbi_traceback(v, 0, v->steps);
+    pk_viterbi_reset(v);
+}
+
+int pk_viterbi_set_isa(pk_viterbi *v, pk_isa isa)
+{
+    if (!pk_isa_supported(isa))
+        return 0;
+
+    switch (isa) {
+        case PK_ISA_SCALAR:
+            v->acs = viterbi_acs_scalar;
+            return 1;
+#if defined(PK_X86_SIMD)
+        case PK_ISA_SSE2:
+            v->acs = viterbi_acs_sse2;
+            return 1;
+        case PK_ISA_AVX2:
+            v->acs = viterbi_acs_avx2;
+            return 1;
+#endif
+        default:
+            return 0;
+    }
+}
+
+unsigned char *pk_viterbi_read(pk_viterbi *v, size_t *nitems)
+{
+    *nitems = pk_block_uu_nitems(v->data);
+    return pk_block_uu_ptr(v->data);
+}
+
+void pk_viterbi_destroy(pk_viterbi *v)
+{
+    pk_block_uu_destroy(v->data);
+    pk_free(v);
 }
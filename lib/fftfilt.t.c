@@ -0,0 +1,203 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Paul Uri David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "plancki.h"
+
+#include <kiss_fft.h>
+#include <kiss_fftr.h>
+
+/* FFT fast convolution filter using overlap-save */
+// input is queued until a block of step new samples sits behind the
+// latest order samples, then one pair of transforms filters the whole
+// block. the first order circular outputs are discarded and the rest
+// match direct form convolution. outputs are handed out while the next
+// block fills, so they lag the input by step samples
+typedef struct pk_fftfilt_XX_s
+{
+    unsigned int order;
+    unsigned int nfft;
+    unsigned int step;
+
+    // forward and inverse transforms, real filters only
+    // keep the nfft / 2 + 1 non-negative frequency bins
+#if PK_COMPLEX_XX
+    kiss_fft_cfg fwd;
+    kiss_fft_cfg inv;
+#else
+    kiss_fftr_cfg fwd;
+    kiss_fftr_cfg inv;
+#endif
+    unsigned int bins;
+
+    // frequency response scaled by 1 / nfft
+    float complex *freq;
+
+    // frequency and time domain workspace
+    float complex *spec;
+    <O> *work;
+
+    // latest order input samples followed by the block being filled
+    <I> *block;
+    size_t fill;
+
+    // filtered samples of the last full block
+    <O> *pending;
+} pk_fftfilt_XX;
+
+static void fftfilt_XX_forward(pk_fftfilt_XX *f, const <I> *input, float complex *output)
+{
+#if PK_COMPLEX_XX
+    kiss_fft(f->fwd, (const kiss_fft_cpx *) input, (kiss_fft_cpx *) output);
+#else
+    kiss_fftr(f->fwd, input, (kiss_fft_cpx *) output);
+#endif
+}
+
+static void fftfilt_XX_inverse(pk_fftfilt_XX *f, const float complex *input, <O> *output)
+{
+#if PK_COMPLEX_XX
+    kiss_fft(f->inv, (const kiss_fft_cpx *) input, (kiss_fft_cpx *) output);
+#else
+    kiss_fftri(f->inv, (const kiss_fft_cpx *) input, output);
+#endif
+}
+
+static void fftfilt_XX_response(pk_fftfilt_XX *f, const <O> *coeff)
+{
+    size_t i;
+    for (i = 0; i < f->nfft; i++)
+        f->work[i] = i <= f->order ? coeff[i] : 0;
+
+    fftfilt_XX_forward(f, f->work, f->freq);
+
+    for (i = 0; i < f->bins; i++)
+        f->freq[i] /= (float) f->nfft;
+}
+
+pk_fftfilt_XX *pk_fftfilt_XX_create(unsigned int order, unsigned int nfft, const <O> *coeff)
+{
+    // transforms of at least four times the filter length
+    // keep the discarded overlap a small fraction of each block
+    if (nfft == 0)
+        nfft = pk_next2pow2(4 * (order + 1));
+
+    if (nfft <= order || nfft % 2) {
+        fprintf(stderr, "FFT filter needs an even transform size above the order!\n");
+        exit(1);
+    }
+
+    pk_fftfilt_XX *f = pk_malloc(sizeof(pk_fftfilt_XX));
+    f->order = order;
+    f->nfft = nfft;
+    f->step = f->nfft - f->order;
+
+    // query the twiddle storage size so it comes from our allocator
+    size_t cfg_size = 0;
+#if PK_COMPLEX_XX
+    kiss_fft_alloc(f->nfft, 0, NULL, &cfg_size);
+
+    f->fwd = kiss_fft_alloc(f->nfft, 0, pk_malloc(cfg_size), &cfg_size);
+    f->inv = kiss_fft_alloc(f->nfft, 1, pk_malloc(cfg_size), &cfg_size);
+    f->bins = f->nfft;
+#else
+    kiss_fftr_alloc(f->nfft, 0, NULL, &cfg_size);
+
+    f->fwd = kiss_fftr_alloc(f->nfft, 0, pk_malloc(cfg_size), &cfg_size);
+    f->inv = kiss_fftr_alloc(f->nfft, 1, pk_malloc(cfg_size), &cfg_size);
+    f->bins = f->nfft / 2 + 1;
+#endif
+
+    f->freq = pk_malloc(f->bins * sizeof(float complex));
+    f->spec = pk_malloc(f->bins * sizeof(float complex));
+    f->work = pk_malloc(f->nfft * sizeof(<O>));
+    f->block = pk_calloc(f->nfft, sizeof(<I>));
+    f->pending = pk_calloc(f->step, sizeof(<O>));
+    f->fill = 0;
+
+    fftfilt_XX_response(f, coeff);
+
+    return f;
+}
+
+void pk_fftfilt_XX_load(pk_fftfilt_XX *f, const <O> *coeff)
+{
+    fftfilt_XX_response(f, coeff);
+}
+
+// filter a full block with a single pair of transforms
+static void fftfilt_XX_block(pk_fftfilt_XX *f)
+{
+    fftfilt_XX_forward(f, f->block, f->spec);
+
+    size_t i;
+    for (i = 0; i < f->bins; i++)
+        f->spec[i] *= f->freq[i];
+
+    fftfilt_XX_inverse(f, f->spec, f->work);
+
+    memcpy(f->pending, f->work + f->order, f->step * sizeof(<O>));
+
+    // the end of this block is the history of the next
+    memmove(f->block, f->block + f->step, f->order * sizeof(<I>));
+}
+
+unsigned int pk_fftfilt_XX_delay(pk_fftfilt_XX *f)
+{
+    return f->step;
+}
+
+void pk_fftfilt_XX_execute(pk_fftfilt_XX *f, <O> *output, const <I> *samples, size_t size)
+{
+    size_t offset = 0;
+    while (offset < size) {
+        size_t num = size - offset;
+        if (num > f->step - f->fill)
+            num = f->step - f->fill;
+
+        // read the input first so the output may overwrite it
+        memcpy(f->block + f->order + f->fill, samples + offset, num * sizeof(<I>));
+        memcpy(output + offset, f->pending + f->fill, num * sizeof(<O>));
+
+        f->fill += num;
+        offset += num;
+
+        if (f->fill == f->step) {
+            fftfilt_XX_block(f);
+            f->fill = 0;
+        }
+    }
+}
+
+void pk_fftfilt_XX_destroy(pk_fftfilt_XX *f)
+{
+    pk_free(f->fwd);
+    pk_free(f->inv);
+
+    pk_free(f->freq);
+    pk_free(f->spec);
+    pk_free(f->work);
+    pk_free(f->block);
+    pk_free(f->pending);
+    pk_free(f);
+}
@@ -66,7 +66,7 @@ pk_iir_cascade *pk_iir_cascade_create(
     const float complex *a, // numerator coefficients
     const float complex *b) // denominator coefficients
 {
-    pk_iir_cascade *iir = malloc(sizeof(pk_iir_cascade));
+    pk_iir_cascade *iir = pk_malloc(sizeof(pk_iir_cascade));
     iir->order = order;
     iir->nsos = iir->order / 2;
 
@@ -75,13 +75,13 @@ pk_iir_cascade *pk_iir_cascade_create(
 
     assert((iir->order % 2) == 0);
 
-    iir->a = malloc((iir->order + 1) * sizeof(float complex));
-    iir->b = malloc((iir->order + 1) * sizeof(float complex));
+    iir->a = pk_malloc((iir->order + 1) * sizeof(float complex));
+    iir->b = pk_malloc((iir->order + 1) * sizeof(float complex));
     memcpy(iir->a, a, (iir->order + 1) * sizeof(float complex));
     memcpy(iir->b, b, (iir->order + 1) * sizeof(float complex));
 
     // allocate memory for second-order sections
-    iir->sos = malloc(iir->nsos * sizeof(pk_iirso_cc));
+    iir->sos = pk_malloc(iir->nsos * sizeof(pk_iirso_cc));
 
     sos_solve(iir);
 
@@ -139,9 +139,9 @@ void pk_iir_cascade_destroy(pk_iir_cascade *iir)
     for (i = 0; i < iir->nsos; i++)
         pk_iirso_cc_destroy(iir->sos[i]);
 
-    free(iir->sos);
+    pk_free(iir->sos);
 
-    free(iir->a);
-    free(iir->b);
-    free(iir);
+    pk_free(iir->a);
+    pk_free(iir->b);
+    pk_free(iir);
 }
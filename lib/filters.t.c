@@ -24,72 +24,302 @@
 
 #include "plancki.h"
 
+// number of outputs computed per coefficient load
+#define FIR_BLOCK_OUTPUTS  8
+
+// number of input samples staged per block
+#define FIR_BLOCK_SAMPLES  2048
+
 /* Simplified FIR filter structure */
 typedef struct pk_fir_XX_s
 {
     unsigned int order;
 
-    // deal with the circular buffer
-    // internally to avoid copies
+    // mirrored history, every sample is written twice so the
+    // latest order + 1 samples are always contiguous in memory
     <I> *buffer;
-    <O> *coeff;
-    unsigned int diff;
-    unsigned int mask;
+    unsigned int len;
     unsigned int index;
+
+    // coefficients are kept time-reversed so each output
+    // is a plain dot product against the history
+    <O> *coeff;
+    pk_dotprod_XX *dp;
+
+    // staging area holding the history followed by a block of input
+    <I> *scratch;
 } pk_fir_XX;
 
-pk_fir_XX *pk_fir_XX_create(unsigned int order, const <O> *coeff)
+static void fir_XX_reverse(pk_fir_XX *fir, const <O> *coeff)
 {
-    pk_fir_XX *fir = malloc(sizeof(pk_fir_XX));
-    fir->order = order;
+    // the dot product conjugates its sequence, so hand it conjugated
+    // taps to cancel that out. they are built in the coefficient storage
+    // and conjugated back once the dot product holds its own copy
+    size_t j;
+    for (j = 0; j < fir->len; j++)
+        fir->coeff[j] = pk_conj_XX(coeff[fir->order - j]);
 
-    unsigned int exponent = pk_next2pow(fir->order + 1);
-    unsigned int size = pk_next2pow2(fir->order + 1);
+    if (fir->dp == NULL)
+        fir->dp = pk_dotprod_XX_create(fir->coeff, fir->len);
+    else
+        pk_dotprod_XX_load(fir->dp, fir->coeff, fir->len);
 
-    fir->diff = size - fir->order - 1;
-    assert(fir->diff >= 0);
+    for (j = 0; j < fir->len; j++)
+        fir->coeff[j] = pk_conj_XX(fir->coeff[j]);
+}
 
-    fir->buffer = calloc(size, sizeof(<I>));
-    fir->mask = (1 << exponent) - 1;
+pk_fir_XX *pk_fir_XX_create(unsigned int order, const <O> *coeff)
+{
+    pk_fir_XX *fir = pk_malloc(sizeof(pk_fir_XX));
+    fir->order = order;
+    fir->len = fir->order + 1;
     fir->index = 0;
 
-    fir->coeff = malloc((fir->order + 1) * sizeof(<O>));
-    memcpy(fir->coeff, coeff, (fir->order + 1) * sizeof(<O>));
+    fir->buffer = pk_calloc(2 * fir->len, sizeof(<I>));
+    fir->scratch = pk_malloc((fir->order + FIR_BLOCK_SAMPLES) * sizeof(<I>));
+
+    fir->dp = NULL;
+    fir->coeff = pk_malloc(fir->len * sizeof(<O>));
+    fir_XX_reverse(fir, coeff);
 
     return fir;
 }
 
 void pk_fir_XX_push(pk_fir_XX *fir, <I> item)
 {
-    fir->buffer[(fir->index++) & fir->mask] = item;
+    fir->buffer[fir->index] = item;
+    fir->buffer[fir->index + fir->len] = item;
+
+    if (++fir->index == fir->len)
+        fir->index = 0;
 }
 
 void pk_fir_XX_load(pk_fir_XX *fir, const <O> *coeff)
 {
-    memcpy(fir->coeff, coeff, (fir->order + 1) * sizeof(<O>));
+    fir_XX_reverse(fir, coeff);
+}
+
+// filter a block of samples with register blocking, every coefficient
+// is loaded once and applied to several neighbouring outputs
+static void fir_XX_block(pk_fir_XX *fir, <O> *output, const <I> *samples, size_t size)
+{
+    <I> *ext = fir->scratch;
+
+    // stage the latest order samples ahead of the new input
+    memcpy(ext, fir->buffer + fir->index + 1, fir->order * sizeof(<I>));
+    memcpy(ext + fir->order, samples, size * sizeof(<I>));
+
+    size_t i = 0;
+
+    // fixed point dot products run on 16-bit multiply-accumulate
+    // kernels, which beat blocking with wide scalar accumulators
+#if !PK_FIXED_XX
+    size_t k, m;
+    for (; i + FIR_BLOCK_OUTPUTS <= size; i += FIR_BLOCK_OUTPUTS) {
+        pk_acc_XX acc[FIR_BLOCK_OUTPUTS] = {0};
+
+        for (k = 0; k < fir->len; k++) {
+            <O> c = fir->coeff[k];
+            const <I> *x = ext + i + k;
+            for (m = 0; m < FIR_BLOCK_OUTPUTS; m++)
+                acc[m] += x[m] * c;
+        }
+
+        for (m = 0; m < FIR_BLOCK_OUTPUTS; m++)
+            output[i + m] = pk_narrow_XX(acc[m]);
+    }
+#endif
+
+    // remaining outputs
+    for (; i < size; i++)
+        output[i] = pk_dotprod_XX_execute(fir->dp, ext + i, fir->len);
+
+    // the newest len samples become the history again
+    const <I> *last = ext + size - 1;
+    memcpy(fir->buffer, last, fir->len * sizeof(<I>));
+    memcpy(fir->buffer + fir->len, last, fir->len * sizeof(<I>));
+    fir->index = 0;
 }
 
 void pk_fir_XX_execute(pk_fir_XX *fir, <O> *output, const <I> *samples, size_t size)
 {
-    size_t i, j;
+    // short calls are cheaper sample by sample
+    if (size < FIR_BLOCK_OUTPUTS) {
+        size_t i;
+        for (i = 0; i < size; i++) {
+            pk_fir_XX_push(fir, samples[i]);
+
+            // oldest sample sits at the write index
+            output[i] = pk_dotprod_XX_execute(fir->dp, fir->buffer + fir->index, fir->len);
+        }
+        return;
+    }
+
+    size_t offset;
+    for (offset = 0; offset < size; offset += FIR_BLOCK_SAMPLES) {
+        size_t num = size - offset;
+        if (num > FIR_BLOCK_SAMPLES)
+            num = FIR_BLOCK_SAMPLES;
+
+        fir_XX_block(fir, output + offset, samples + offset, num);
+    }
+}
+
+void pk_fir_XX_destroy(pk_fir_XX *fir)
+{
+    pk_dotprod_XX_destroy(fir->dp);
+    pk_free(fir->coeff);
+    pk_free(fir->scratch);
+    pk_free(fir->buffer);
+    pk_free(fir);
+}
+
+
+/* Decimating FIR filter */
+// only the outputs that are kept get computed,
+// one for every factor input samples
+typedef struct pk_firdecim_XX_s
+{
+    unsigned int factor;
+    unsigned int count;
+    pk_fir_XX *fir;
+} pk_firdecim_XX;
+
+pk_firdecim_XX *pk_firdecim_XX_create(unsigned int factor, unsigned int order, const <O> *coeff)
+{
+    assert(factor > 0);
+
+    pk_firdecim_XX *d = pk_malloc(sizeof(pk_firdecim_XX));
+    d->factor = factor;
+    d->count = 0;
+    d->fir = pk_fir_XX_create(order, coeff);
+
+    return d;
+}
+
+void pk_firdecim_XX_load(pk_firdecim_XX *d, const <O> *coeff)
+{
+    pk_fir_XX_load(d->fir, coeff);
+}
+
+size_t pk_firdecim_XX_execute(pk_firdecim_XX *d, <O> *output, const <I> *samples, size_t size)
+{
+    pk_fir_XX *fir = d->fir;
+    size_t nitems = 0;
+
+    size_t i;
     for (i = 0; i < size; i++) {
         pk_fir_XX_push(fir, samples[i]);
-        output[i] = 0;
-        for (j = 0; j <= fir->order; j++) {
-            size_t index = (j + fir->diff + fir->index) & fir->mask;
-            output[i] += (fir->buffer[index] * fir->coeff[fir->order - j]);
+
+        if (++d->count == d->factor) {
+            output[nitems++] = pk_dotprod_XX_execute(fir->dp, fir->buffer + fir->index, fir->len);
+            d->count = 0;
         }
     }
+
+    return nitems;
 }
 
-void pk_fir_XX_destroy(pk_fir_XX *fir)
+void pk_firdecim_XX_destroy(pk_firdecim_XX *d)
 {
-    free(fir->coeff);
-    free(fir->buffer);
-    free(fir);
+    pk_fir_XX_destroy(d->fir);
+    pk_free(d);
 }
 
 
+/* Polyphase interpolating FIR filter */
+// the filter is split into factor sub-filters that run at the
+// input rate, so none of the zero-stuffed samples are multiplied
+typedef struct pk_firinterp_XX_s
+{
+    unsigned int order;
+    unsigned int factor;
+
+    // mirrored input history of the sub-filter length
+    <I> *buffer;
+    unsigned int len;
+    unsigned int index;
+
+    // one time-reversed sub-filter per output phase, and
+    // room to build each one's taps before it is loaded
+    pk_dotprod_XX **phase;
+    <O> *taps;
+} pk_firinterp_XX;
+
+static void firinterp_XX_split(pk_firinterp_XX *f, const <O> *coeff)
+{
+    <O> *taps = f->taps;
+
+    size_t p, j;
+    for (p = 0; p < f->factor; p++) {
+        for (j = 0; j < f->len; j++) {
+            // newest sample pairs with the first tap of the phase
+            size_t k = p + (f->len - 1 - j) * f->factor;
+            taps[j] = k <= f->order ? pk_conj_XX(coeff[k]) : 0;
+        }
+
+        if (f->phase[p] == NULL)
+            f->phase[p] = pk_dotprod_XX_create(taps, f->len);
+        else
+            pk_dotprod_XX_load(f->phase[p], taps, f->len);
+    }
+}
+
+pk_firinterp_XX *pk_firinterp_XX_create(unsigned int factor, unsigned int order, const <O> *coeff)
+{
+    assert(factor > 0);
+
+    pk_firinterp_XX *f = pk_malloc(sizeof(pk_firinterp_XX));
+    f->order = order;
+    f->factor = factor;
+
+    f->len = (f->order + f->factor) / f->factor;
+    f->index = 0;
+    f->buffer = pk_calloc(2 * f->len, sizeof(<I>));
+
+    f->phase = pk_calloc(f->factor, sizeof(pk_dotprod_XX *));
+    f->taps = pk_malloc(f->len * sizeof(<O>));
+    firinterp_XX_split(f, coeff);
+
+    return f;
+}
+
+void pk_firinterp_XX_load(pk_firinterp_XX *f, const <O> *coeff)
+{
+    firinterp_XX_split(f, coeff);
+}
+
+void pk_firinterp_XX_execute(pk_firinterp_XX *f, <O> *output, const <I> *samples, size_t size)
+{
+    size_t i, p;
+    for (i = 0; i < size; i++) {
+        f->buffer[f->index] = samples[i];
+        f->buffer[f->index + f->len] = samples[i];
+
+        if (++f->index == f->len)
+            f->index = 0;
+
+        const <I> *window = f->buffer + f->index;
+        for (p = 0; p < f->factor; p++)
+            output[i * f->factor + p] = pk_dotprod_XX_execute(f->phase[p], window, f->len);
+    }
+}
+
+void pk_firinterp_XX_destroy(pk_firinterp_XX *f)
+{
+    size_t p;
+    for (p = 0; p < f->factor; p++)
+        pk_dotprod_XX_destroy(f->phase[p]);
+
+    pk_free(f->phase);
+    pk_free(f->taps);
+    pk_free(f->buffer);
+    pk_free(f);
+}
+
+
+#if !PK_FIXED_XX
+
 /* Second-order IIR filter:
  * modified version of direct form I */
 typedef struct pk_iirso_XX_s
@@ -102,11 +332,11 @@ typedef struct pk_iirso_XX_s
 
 pk_iirso_XX *pk_iirso_XX_create(const <O> *a, const <O> *b)
 {
-    pk_iirso_XX *iir = malloc(sizeof(pk_iirso_XX));
-    iir->buffer = calloc(2, sizeof(<I>));
+    pk_iirso_XX *iir = pk_malloc(sizeof(pk_iirso_XX));
+    iir->buffer = pk_calloc(2, sizeof(<I>));
 
-    iir->a = malloc(3 * sizeof(<O>));
-    iir->b = malloc(3 * sizeof(<O>));
+    iir->a = pk_malloc(3 * sizeof(<O>));
+    iir->b = pk_malloc(3 * sizeof(<O>));
     memcpy(iir->a, a, 3 * sizeof(<O>));
     memcpy(iir->b, b, 3 * sizeof(<O>));
 
@@ -149,9 +379,11 @@ void pk_iirso_XX_execute(pk_iirso_XX *iir, <O> *output, const <I> *samples, size
 
 void pk_iirso_XX_destroy(pk_iirso_XX *iir)
 {
-    free(iir->a);
-    free(iir->b);
+    pk_free(iir->a);
+    pk_free(iir->b);
 
-    free(iir->buffer);
-    free(iir);
+    pk_free(iir->buffer);
+    pk_free(iir);
 }
+
+#endif
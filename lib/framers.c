@@ -25,24 +25,77 @@
 #include "plancki.h"
 
 /* AX.25 framing object */
+// the frame is built as packed bits with the first bit in the lsb.
+// bit stuffing goes a byte at a time through a table indexed by the
+// running ones count, and NRZI is a prefix xor over each 32 bit chunk
 typedef struct pk_ax25_framer_s
 {
     unsigned int padding;
     unsigned int count;
+
+    // packed bit writer
+    uint64_t acc;
+    unsigned int nacc;
+    unsigned char *out;
+    size_t nbits;
+
+    // optional NRZI and the line level carried between frames
+    int nrzi;
+    unsigned int level;
+
+    // stuffing table indexed by ones count and input byte, each entry
+    // holds the output bits, their count and the ones count after
+    uint32_t stuff[5][256];
+
     pk_block_uu *frame;
+    pk_block_uu *packed;
+    pk_crc *crc;
 } pk_ax25_framer;
 
 pk_ax25_framer *pk_ax25_framer_create(unsigned int padding)
 {
-    pk_ax25_framer *f = malloc(sizeof(pk_ax25_framer));
+    pk_ax25_framer *f = pk_malloc(sizeof(pk_ax25_framer));
 
     f->frame = pk_block_uu_create(8 * MAX_AX25_BYTES);
+    f->packed = pk_block_uu_create(MAX_AX25_BYTES);
+    f->crc = pk_crc_create_preset(PK_CRC_AX25);
     f->padding = padding;
     f->count = 0;
+    f->nrzi = 0;
+    f->level = 0;
+
+    // a zero follows every fifth one in a row
+    unsigned int ones, byte, i;
+    for (ones = 0; ones < 5; ones++) {
+        for (byte = 0; byte < 256; byte++) {
+            unsigned int run = ones;
+            uint32_t bits = 0;
+            unsigned int nbits = 0;
+
+            for (i = 0; i < 8; i++) {
+                unsigned int bit = (byte >> i) & 1;
+                bits |= bit << nbits++;
+
+                run = bit ? run + 1 : 0;
+                if (run == 5) {
+                    nbits++;
+                    run = 0;
+                }
+            }
+
+            f->stuff[ones][byte] = bits | nbits << 16 | run << 20;
+        }
+    }
 
     return f;
 }
 
+void pk_ax25_framer_set_nrzi(pk_ax25_framer *f, int enable)
+{
+    f->nrzi = enable;
+    f->level = 0;
+}
+
 static void print_ax25_framer(pk_ax25_framer *f)
 {
     unsigned char *data = pk_block_uu_ptr(f->frame);
@@ -62,61 +115,124 @@ static void print_ax25_framer(pk_ax25_framer *f)
     printf("    end stream.\n");
 }
 
-static void ax25_insert_pad(pk_ax25_framer *f)
+// write the low num bits of the writer, at most 32
+static void ax25_flush_bits(pk_ax25_framer *f, unsigned int num)
 {
+    uint32_t mask = num == 32 ? 0xffffffff : ((uint32_t) 1 << num) - 1;
+    uint32_t word = (uint32_t) f->acc & mask;
+
+    // a zero toggles the line, the level is the prefix xor of the toggles
+    if (f->nrzi) {
+        word = ~word & mask;
+        word ^= word << 1;
+        word ^= word << 2;
+        word ^= word << 4;
+        word ^= word << 8;
+        word ^= word << 16;
+        if (f->level)
+            word = ~word;
+        word &= mask;
+        f->level = (word >> (num - 1)) & 1;
+    }
+
     size_t i;
-    for (i = 0; i < f->padding; i++)
-        pk_block_uu_push(f->frame, 0);
+    for (i = 0; 8 * i < num; i++)
+        f->out[f->nbits / 8 + i] = (word >> (8 * i)) & 0xff;
+
+    f->acc >>= num;
+    f->nacc -= num;
+    f->nbits += num;
+}
+
+// append num bits, at most 16
+static void ax25_put_bits(pk_ax25_framer *f, uint32_t bits, unsigned int num)
+{
+    f->acc |= (uint64_t) bits << f->nacc;
+    f->nacc += num;
+
+    if (f->nacc >= 32)
+        ax25_flush_bits(f, 32);
+}
+
+static void ax25_insert_pad(pk_ax25_framer *f)
+{
+    unsigned int left = f->padding;
+    for (; left > 16; left -= 16)
+        ax25_put_bits(f, 0, 16);
+    ax25_put_bits(f, 0, left);
 }
 
 static void ax25_insert_flag(pk_ax25_framer *f)
+{
+    ax25_put_bits(f, AX25_FLAG, 8);
+}
+
+static void ax25_stuff_bytes(pk_ax25_framer *f, const unsigned char *bytes, size_t size)
 {
     size_t i;
-    for (i = 0; i < 8; i++)
-        pk_block_uu_push(f->frame, (AX25_FLAG >> i) & 1);
+    for (i = 0; i < size; i++) {
+        uint32_t entry = f->stuff[f->count][bytes[i]];
+        ax25_put_bits(f, entry & 0xffff, (entry >> 16) & 0xf);
+        f->count = entry >> 20;
+    }
 }
 
-void pk_ax25_framer_process(
+void pk_ax25_framer_process_packed(
     pk_ax25_framer *f,
     const unsigned char *bytes,
     size_t size)
 {
-    pk_block_uu_clear(f->frame);
+    pk_block_uu_clear(f->packed);
 
     unsigned int crc;
     unsigned char crc_bytes[2] = {0};
 
-    crc  = crc_ax25_byte(bytes, size);
-    crc ^= 0xffff;
+    crc = pk_crc_compute(f->crc, bytes, size);
     crc_bytes[0] |= (crc & 0x00ff);
     crc_bytes[1] |= (crc & 0xff00) >> 8;
 
+    // at worst two stuffed bits follow every byte, plus a partial word
+    size_t max_bits = 2 * (size_t) f->padding + 16 + 10 * (size + 2);
+    f->out = pk_block_uu_begin_write(f->packed, max_bits / 8 + 4);
+    f->acc = 0;
+    f->nacc = 0;
+    f->nbits = 0;
+
     ax25_insert_pad(f);
     ax25_insert_flag(f);
 
-    size_t i, j, c = 0;
-    for (i = 0; i < size + 2; i++) {
-        unsigned char bits[8];
+    // the receiver counts ones from the flag, so stuffing has to restart
+    // there rather than carry on from the end of the previous frame
+    f->count = 0;
+    ax25_stuff_bytes(f, bytes, size);
+    ax25_stuff_bytes(f, crc_bytes, 2);
 
-        if (i < size)
-            pk_unpack_byte_rl(bits, bytes[i]);
-        else
-            pk_unpack_byte_rl(bits, crc_bytes[c++]);
+    ax25_insert_flag(f);
+    ax25_insert_pad(f);
 
-        for (j = 0; j < 8; j++) {
-            pk_block_uu_push(f->frame, bits[j]);
-            f->count = bits[j] & 1 ? ++f->count : 0;
+    if (f->nacc > 0)
+        ax25_flush_bits(f, f->nacc);
 
-            // bit stuff after we've seen 5 ones
-            if (f->count == 5) {
-                pk_block_uu_push(f->frame, 0);
-                f->count = 0;
-            }
-        }
-    }
+    pk_block_uu_commit(f->packed, (f->nbits + 7) / 8);
+}
 
-    ax25_insert_flag(f);
-    ax25_insert_pad(f);
+void pk_ax25_framer_process(
+    pk_ax25_framer *f,
+    const unsigned char *bytes,
+    size_t size)
+{
+    pk_ax25_framer_process_packed(f, bytes, size);
+
+    pk_block_uu_clear(f->frame);
+
+    const unsigned char *packed = pk_block_uu_ptr(f->packed);
+    unsigned char *out = pk_block_uu_begin_write(f->frame, f->nbits);
+
+    size_t i;
+    for (i = 0; i < f->nbits; i++)
+        out[i] = (packed[i / 8] >> (i % 8)) & 1;
+
+    pk_block_uu_commit(f->frame, f->nbits);
 
 #if PK_DEBUG == VERBOSE
     print_ax25_framer(f);
@@ -131,10 +247,20 @@ unsigned char *pk_ax25_framer_read(pk_ax25_framer *f, size_t *out_nitems)
     return pk_block_uu_ptr(f->frame);
 }
 
+unsigned char *pk_ax25_framer_read_packed(pk_ax25_framer *f, size_t *out_nbits)
+{
+    if (out_nbits != NULL)
+        *out_nbits = f->nbits;
+
+    return pk_block_uu_ptr(f->packed);
+}
+
 void pk_ax25_framer_destroy(pk_ax25_framer *f)
 {
     pk_block_uu_destroy(f->frame);
-    free(f);
+    pk_block_uu_destroy(f->packed);
+    pk_crc_destroy(f->crc);
+    pk_free(f);
 }
 
 typedef enum {
@@ -143,164 +269,347 @@ typedef enum {
 } ax25_mode;
 
 /* AX.25 deframing object */
+// bits are handled a word at a time with the first bit in the lsb.
+// the last 7 bits of the previous word are kept so flags spanning
+// two words are found, and a frame is collected raw as packed bits
+// until the closing flag, then unstuffed a byte at a time.
+#define AX25_WORD_BITS  56
+#define AX25_RAW_BITS   (8 * MAX_AX25_BYTES)
+#define AX25_RAW_WORDS  (AX25_RAW_BITS / 64 + 1)
+
 typedef struct pk_ax25_deframer_s
 {
     ax25_mode state;
     unsigned int count;
+    uint64_t history;
 
     void *info;
     void (*callback)(int valid, unsigned char *payload, void *info, size_t size);
 
-    pk_block_uu *data;
+    // raw bits since the opening flag
+    uint64_t raw[AX25_RAW_WORDS];
+
+    // unstuffing table indexed by ones count and input byte, each entry
+    // holds the kept bits, their count and the ones count after
+    uint16_t unstuff[6][256];
+
     pk_block_uu *packed;
-    pk_circ_uu *window;
-    pk_circ_uu *buffer;
+    pk_crc *crc;
 } pk_ax25_deframer;
 
 pk_ax25_deframer *pk_ax25_deframer_create(
     void *info,
     void (*callback_ptr)(int valid, unsigned char *payload, void *info, size_t size))
 {
-    pk_ax25_deframer *df = malloc(sizeof(pk_ax25_deframer));
+    pk_ax25_deframer *df = pk_malloc(sizeof(pk_ax25_deframer));
     df->info = info;
     df->callback = callback_ptr;
 
     df->state = AX25_DETECT;
     df->count = 0;
+    df->history = 0;
+
+    // a bit after five ones is dropped whatever its value
+    unsigned int ones, byte, i;
+    for (ones = 0; ones < 6; ones++) {
+        for (byte = 0; byte < 256; byte++) {
+            unsigned int run = ones;
+            unsigned int kept = 0;
+            unsigned int nkept = 0;
+
+            for (i = 0; i < 8; i++) {
+                unsigned int bit = (byte >> i) & 1;
+                if (run < 5)
+                    kept |= bit << nkept++;
+                run = bit ? (run < 5 ? run + 1 : 5) : 0;
+            }
+
+            df->unstuff[ones][byte] = kept | nkept << 8 | run << 12;
+        }
+    }
 
-    df->data = pk_block_uu_create(8 * MAX_AX25_BYTES);
     df->packed = pk_block_uu_create(MAX_AX25_BYTES);
-    df->window = pk_circ_uu_create(8);
-    df->buffer = pk_circ_uu_create(8);
+    df->crc = pk_crc_create_preset(PK_CRC_AX25);
 
     return df;
 }
 
 static void ax25_unstuff_bits(pk_ax25_deframer *df)
 {
-    // reset everything
     pk_block_uu_clear(df->packed);
-    pk_circ_uu_clear(df->buffer);
 
     // subtract end of the flag
-    size_t size = pk_block_uu_nitems(df->data);
+    size_t size = df->count;
     assert(size > 7);
+    size -= 7;
 
-    size_t count = 0;
-    size_t ones  = 0;
+    unsigned int ones = 0;
+    unsigned int acc = 0;
+    unsigned int nacc = 0;
+    size_t n = 0;
 
-    unsigned char *data = pk_block_uu_ptr(df->data);
+    unsigned char *packed = pk_block_uu_begin_write(df->packed, size / 8);
 
     size_t i;
-    for (i = 0; i < size - 7; i++) {
-        if (ones < 5) {
-            pk_circ_uu_push(df->buffer, data[i]);
-            count++;
+    for (i = 0; i + 8 <= size; i += 8) {
+        unsigned int byte = (df->raw[i / 64] >> (i % 64)) & 0xff;
+        unsigned int entry = df->unstuff[ones][byte];
+
+        acc |= (entry & 0xff) << nacc;
+        nacc += (entry >> 8) & 0xf;
+        ones = entry >> 12;
+
+        if (nacc >= 8) {
+            packed[n++] = acc & 0xff;
+            acc >>= 8;
+            nacc -= 8;
         }
+    }
 
-        ones = data[i] & 1 ? ++ones : 0;
-
-        if (count == 8) {
-            unsigned char input[8];
-            pk_circ_uu_read(df->buffer, input, 8);
-            unsigned char byte = pk_pack_byte_rl(input);
-            pk_block_uu_push(df->packed, byte);
-            count = 0;
+    // trailing bits that don't fill a byte
+    for (; i < size; i++) {
+        unsigned int bit = (df->raw[i / 64] >> (i % 64)) & 1;
+        if (ones < 5)
+            acc |= bit << nacc++;
+        ones = bit ? (ones < 5 ? ones + 1 : 5) : 0;
+
+        if (nacc == 8) {
+            packed[n++] = acc & 0xff;
+            acc = 0;
+            nacc = 0;
         }
     }
+
+    pk_block_uu_commit(df->packed, n);
 }
 
-void pk_ax25_deframer_process(
-    pk_ax25_deframer *df,
-    const unsigned char *bits,
-    size_t size)
+// append the low num bits of word to the raw frame
+static void ax25_append_bits(pk_ax25_deframer *df, uint64_t word, unsigned int num)
 {
-    size_t i;
-    for (i = 0; i < size; i++) {
-        unsigned char input[8];
-        pk_circ_uu_push(df->window, bits[i]);
-        pk_circ_uu_read(df->window, input, 8);
-        unsigned char byte = pk_pack_byte_rl(input);
-
-        if (df->state == AX25_DETECT) {
-            if (byte == AX25_FLAG) {
+    if (df->state != AX25_DECODE || num == 0)
+        return;
 
+    if (df->count + num > AX25_RAW_BITS) {
+        df->state = AX25_DETECT;
 #if PK_DEBUG == VERBOSE
-                printf("***** pk_ax25_deframer_process debug ******\n");
-                printf("    Detected AX.25 frame.\n");
+        printf("***** pk_ax25_deframer_process debug ******\n");
+        printf("    AX.25 frame exceeded defined maximum of\n");
+        printf("    %d bytes.\n", MAX_AX25_BYTES);
 #endif
+        return;
+    }
 
-                df->state = AX25_DECODE;
-                df->count = 0;
-                pk_circ_uu_clear(df->window);
-            }
-        } else if (df->state == AX25_DECODE) {
-            if (df->count > 8 * MAX_AX25_BYTES) {
+    word &= ((uint64_t) 1 << num) - 1;
 
-                df->state = AX25_DETECT;
-#if PK_DEBUG == VERBOSE
-                printf("***** pk_ax25_deframer_process debug ******\n");
-                printf("    AX.25 frame exceeded defined maximum of\n");
-                printf("    %d bytes.\n", MAX_AX25_BYTES);
-#endif
-                pk_block_uu_clear(df->data);
-                pk_block_uu_clear(df->packed);
+    unsigned int index = df->count / 64;
+    unsigned int offset = df->count % 64;
 
-            } else if (byte == AX25_FLAG) {
+    if (offset == 0)
+        df->raw[index] = word;
+    else
+        df->raw[index] |= word << offset;
 
-                df->state = AX25_DETECT;
+    if (offset + num > 64)
+        df->raw[index + 1] = word >> (64 - offset);
+
+    df->count += num;
+}
 
-                if (df->count > MIN_AX25_BYTES) {
+static void ax25_end_frame(pk_ax25_deframer *df)
+{
+    if (df->state != AX25_DECODE || df->count <= MIN_AX25_BYTES)
+        return;
 
-                    // unstuff the received frame
-                    ax25_unstuff_bits(df);
+    // unstuff the received frame
+    ax25_unstuff_bits(df);
 
-                    size_t frame_size = pk_block_uu_nitems(df->packed);
-                    unsigned char *frame_data = pk_block_uu_ptr(df->packed);
+    size_t frame_size = pk_block_uu_nitems(df->packed);
+    unsigned char *frame_data = pk_block_uu_ptr(df->packed);
 
-                    // calculate the CRC and check for the magic number
-                    unsigned int result = crc_ax25_byte(frame_data, frame_size);
-                    int valid = result == AX25_CRC_MAGIC;
+    // run the CRC over the FCS too and check the register for the magic number
+    unsigned int result = pk_crc_update(df->crc, pk_crc_init(df->crc), frame_data, frame_size);
+    int valid = result == AX25_CRC_MAGIC;
 
 #if PK_DEBUG == VERBOSE
-                    printf("***** pk_ax25_deframer_process debug ******\n");
-                    printf("    Detected end of an AX.25 frame.\n");
-                    printf("    CRC calculation :    %d\n", result);
-                    printf("    CRC magic calc  :    %d\n", AX25_CRC_MAGIC);
-                    printf("    Frame ASCII     :\n");
-
-                    size_t r, c;
-                    for (r = 0; r < frame_size / 8 + 1; r++) {
-                        for (c = 0; c < 8; c++) {
-                            if (8 * r + c < frame_size)
-                                printf("    %c", frame_data[8*r+c]);
-                        }
-                        printf("\n");
-                    }
+    printf("***** pk_ax25_deframer_process debug ******\n");
+    printf("    Detected end of an AX.25 frame.\n");
+    printf("    CRC calculation :    %d\n", result);
+    printf("    CRC magic calc  :    %d\n", AX25_CRC_MAGIC);
+    printf("    Frame ASCII     :\n");
+
+    size_t r, c;
+    for (r = 0; r < frame_size / 8 + 1; r++) {
+        for (c = 0; c < 8; c++) {
+            if (8 * r + c < frame_size)
+                printf("    %c", frame_data[8*r+c]);
+        }
+        printf("\n");
+    }
 #endif
 
-                    // pass payload to a callback
-                    df->callback(valid, frame_data, df->info, frame_size);
-                    df->state = AX25_DETECT;
-                }
+    // pass payload to a callback
+    df->callback(valid, frame_data, df->info, frame_size);
+}
 
-                pk_block_uu_clear(df->data);
-                pk_block_uu_clear(df->packed);
+// run num bits of word, at most AX25_WORD_BITS, through the deframer
+static void ax25_deframe_word(pk_ax25_deframer *df, uint64_t word, unsigned int num)
+{
+    word &= ((uint64_t) 1 << num) - 1;
+
+    // bit p of flags marks a flag 0111 1110 ending on word bit p
+    uint64_t ext = word << 7 | df->history;
+    uint64_t flags = ~ext & ext >> 1 & ext >> 2 & ext >> 3 & ext >> 4
+                   & ext >> 5 & ext >> 6 & ~(ext >> 7);
+    flags &= ((uint64_t) 1 << num) - 1;
+
+    unsigned int start = 0;
+    unsigned int p = 0;
+    while (flags) {
+        while (!((flags >> p) & 1))
+            p++;
+        flags &= flags - 1;
+
+        // the closing flag is also the opening flag of the next frame
+        ax25_append_bits(df, word >> start, p - start);
+        ax25_end_frame(df);
+
+        df->state = AX25_DECODE;
+        df->count = 0;
+        start = p + 1;
+    }
 
-            } else {
-                pk_block_uu_push(df->data, bits[i]);
-                df->count++;
-            }
-        }
+    ax25_append_bits(df, word >> start, num - start);
+    df->history = (ext >> num) & 0x7f;
+}
+
+void pk_ax25_deframer_process(
+    pk_ax25_deframer *df,
+    const unsigned char *bits,
+    size_t size)
+{
+    while (size > 0) {
+        unsigned int num = size < AX25_WORD_BITS ? size : AX25_WORD_BITS;
+
+        uint64_t word = 0;
+        unsigned int i;
+        for (i = 0; i < num; i++)
+            word |= (uint64_t) (bits[i] & 1) << i;
+
+        ax25_deframe_word(df, word, num);
+        bits += num;
+        size -= num;
+    }
+}
+
+void pk_ax25_deframer_process_packed(
+    pk_ax25_deframer *df,
+    const unsigned char *bytes,
+    size_t size)
+{
+    while (size > 0) {
+        unsigned int num = size < AX25_WORD_BITS / 8 ? size : AX25_WORD_BITS / 8;
+
+        uint64_t word = 0;
+        unsigned int i;
+        for (i = 0; i < num; i++)
+            word |= (uint64_t) bytes[i] << (8 * i);
+
+        ax25_deframe_word(df, word, 8 * num);
+        bytes += num;
+        size -= num;
     }
 }
 
 void pk_ax25_deframer_destroy(pk_ax25_deframer *df)
 {
-    pk_block_uu_destroy(df->data);
     pk_block_uu_destroy(df->packed);
-    pk_circ_uu_destroy(df->window);
-    pk_circ_uu_destroy(df->buffer);
+    pk_crc_destroy(df->crc);
+
+    pk_free(df);
+}
+
+/* G3RUH receive chain */
+// descrambles with 1 + x^12 + x^17, undoes NRZI and deframes a word at
+// a time. the last 17 received bits and the last descrambled bit are
+// kept between words
+#define G3RUH_WORD_BITS 40
+
+typedef struct pk_g3ruh_deframer_s
+{
+    uint64_t history;
+    unsigned int level;
+    pk_ax25_deframer *deframer;
+} pk_g3ruh_deframer;
+
+pk_g3ruh_deframer *pk_g3ruh_deframer_create(
+    void *info,
+    void (*callback_ptr)(int valid, unsigned char *payload, void *info, size_t size))
+{
+    pk_g3ruh_deframer *g = pk_malloc(sizeof(pk_g3ruh_deframer));
+    g->history = 0;
+    g->level = 0;
+    g->deframer = pk_ax25_deframer_create(info, callback_ptr);
+
+    return g;
+}
+
+static void g3ruh_deframe_word(pk_g3ruh_deframer *g, uint64_t word, unsigned int num)
+{
+    uint64_t mask = ((uint64_t) 1 << num) - 1;
+    word &= mask;
+
+    // out[t] = in[t] ^ in[t-12] ^ in[t-17]
+    uint64_t ext = word << 17 | g->history;
+    uint64_t line = (ext ^ ext >> 5 ^ ext >> 17) & mask;
+    g->history = (ext >> num) & 0x1ffff;
+
+    // a one is sent as no change in the line level
+    uint64_t bits = ~(line ^ (line << 1 | g->level)) & mask;
+    g->level = (line >> (num - 1)) & 1;
+
+    ax25_deframe_word(g->deframer, bits, num);
+}
 
-    free(df);
+void pk_g3ruh_deframer_process(
+    pk_g3ruh_deframer *g,
+    const unsigned char *bits,
+    size_t size)
+{
+    while (size > 0) {
+        unsigned int num = size < G3RUH_WORD_BITS ? size : G3RUH_WORD_BITS;
+
+        uint64_t word = 0;
+        unsigned int i;
+        for (i = 0; i < num; i++)
+            word |= (uint64_t) (bits[i] & 1) << i;
+
+        g3ruh_deframe_word(g, word, num);
+        bits += num;
+        size -= num;
+    }
+}
+
+void pk_g3ruh_deframer_process_packed(
+    pk_g3ruh_deframer *g,
+    const unsigned char *bytes,
+    size_t size)
+{
+    while (size > 0) {
+        unsigned int num = size < G3RUH_WORD_BITS / 8 ? size : G3RUH_WORD_BITS / 8;
+
+        uint64_t word = 0;
+        unsigned int i;
+        for (i = 0; i < num; i++)
+            word |= (uint64_t) bytes[i] << (8 * i);
+
+        g3ruh_deframe_word(g, word, 8 * num);
+        bytes += num;
+        size -= num;
+    }
+}
+
+void pk_g3ruh_deframer_destroy(pk_g3ruh_deframer *g)
+{
+    pk_ax25_deframer_destroy(g->deframer);
+    pk_free(g);
 }
@@ -24,6 +24,25 @@
 
 #include "plancki.h"
 
+// soft value of an NRZI coded bit from the signed tone metrics of the
+// current and previous symbol, positive favours a one (no transition).
+// the metrics are normalized by the symbol energy to -1..1, and so is
+// the result, +1 being a confident one
+static float nrzi_soft(float cur, float past)
+{
+    float mag = fabsf(cur) < fabsf(past) ? fabsf(cur) : fabsf(past);
+    return (cur < 0) == (past < 0) ? mag : -mag;
+}
+
+// most decisions the NRZI demodulators can make on num samples. they
+// are a symbol apart, but a transition just after a decision pulls the
+// next one in to half a symbol, and one may be due on the first sample
+static size_t nrzi_max_bits(unsigned int samp_sym, size_t num)
+{
+    size_t gap = samp_sym / 2 > 0 ? samp_sym / 2 : 1;
+    return num / gap + 1;
+}
+
 /* BFSK modem objects */
 // continuous binary BFSK modulator meant
 // for amateur radio modems like AFSK 1200
@@ -34,8 +53,7 @@ typedef struct pk_bfskmod_s
     unsigned char past;
     float samp_rate;
 
-    float phase;
-    float phase_inc;
+    pk_nco *nco;
 
     float mark_freq;
     float space_freq;
@@ -48,17 +66,17 @@ pk_bfskmod *pk_bfskmod_create(
     float mark_freq,         // mark frequency  (1)
     float space_freq)        // space frequency (0)
 {
-    pk_bfskmod *fm = malloc(sizeof(pk_bfskmod));
+    pk_bfskmod *fm = pk_malloc(sizeof(pk_bfskmod));
     fm->samp_sym = samp_sym;
     fm->samp_rate = fm->samp_sym * baud;
 
-    fm->phase_inc = 0;
-    fm->phase = 0;
     fm->past = 0;
 
     fm->mark_freq = (2.0f * M_PI * mark_freq / fm->samp_rate);
     fm->space_freq = (2.0f * M_PI * space_freq / fm->samp_rate);
 
+    fm->nco = pk_nco_create(fm->space_freq, 1);
+
     return fm;
 }
 
@@ -66,18 +84,10 @@ pk_bfskmod *pk_bfskmod_create(
 void pk_bfskmod_execute(pk_bfskmod *fm, float complex *sym, unsigned char bit)
 {
     if (bit == 0) fm->past = fm->past != 1;
-    fm->phase_inc = fm->past ? fm->mark_freq : fm->space_freq;
-
-    size_t i;
-    for (i = 0; i < fm->samp_sym; i++) {
-        fm->phase += fm->phase_inc;
+    pk_nco_set_frequency(fm->nco, fm->past ? fm->mark_freq : fm->space_freq);
 
-        // perform phase unwrapping
-        while (fm->phase > 2*M_PI)
-            fm->phase -= 2*M_PI;
-
-        sym[i] = cexpf(I * fm->phase);
-    }
+    // the phase stays continuous across symbols
+    pk_nco_generate(fm->nco, sym, fm->samp_sym);
 }
 
 // process a batch of bits
@@ -95,7 +105,8 @@ void pk_bfskmod_process(
 // destroy the BFSK modulator
 void pk_bfskmod_destroy(pk_bfskmod *fm)
 {
-    free(fm);
+    pk_nco_destroy(fm->nco);
+    pk_free(fm);
 }
 
 // continuous BFSK demodulator
@@ -110,7 +121,24 @@ typedef struct pk_bfskdemod_s
     float complex *mark_filt;
     float complex *space_filt;
 
-    pk_circ_cc *window;
+    // sliding correlator state, the products of the last
+    // samp_sym samples with each tone are kept in a ring
+    size_t pos;
+    float complex *mark_prod;
+    float complex *space_prod;
+    float complex mark_sum;
+    float complex space_sum;
+    float complex mark_rot;
+    float complex space_rot;
+    float complex mark_step;
+    float complex space_step;
+
+    // mark minus space energy over their sum for the current
+    // window and at the last decision, for the optional soft output
+    float metric;
+    float past_metric;
+    pk_block_ff *soft;
+
     pk_block_uu *data;
 } pk_bfskdemod;
 
@@ -121,12 +149,15 @@ pk_bfskdemod *pk_bfskdemod_create(
     float mark_freq,         // mark frequency  (1)
     float space_freq)        // space frequency (0)
 {
-    pk_bfskdemod *fd  = malloc(sizeof(pk_bfskdemod));
+    pk_bfskdemod *fd  = pk_malloc(sizeof(pk_bfskdemod));
     fd->samp_sym = samp_sym;
 
     fd->data = pk_block_uu_create(1024);
-    fd->mark_filt  = malloc(fd->samp_sym * sizeof(float complex));
-    fd->space_filt = malloc(fd->samp_sym * sizeof(float complex));
+    fd->soft = NULL;
+    fd->metric = 0;
+    fd->past_metric = 0;
+    fd->mark_filt  = pk_malloc(fd->samp_sym * sizeof(float complex));
+    fd->space_filt = pk_malloc(fd->samp_sym * sizeof(float complex));
 
     fd->diff = 0;
     fd->timer = 0;
@@ -155,8 +186,15 @@ pk_bfskdemod *pk_bfskdemod_create(
         fd->space_filt[i] = cexpf(-1.0f * I * sphase);
     }
 
-    // create window
-    fd->window = pk_circ_cc_create(fd->samp_sym);
+    fd->pos = 0;
+    fd->mark_prod  = pk_calloc(fd->samp_sym, sizeof(float complex));
+    fd->space_prod = pk_calloc(fd->samp_sym, sizeof(float complex));
+    fd->mark_sum  = 0;
+    fd->space_sum = 0;
+    fd->mark_rot  = 1;
+    fd->space_rot = 1;
+    fd->mark_step  = cexpf(-1.0f * I * mphase_inc);
+    fd->space_step = cexpf(-1.0f * I * sphase_inc);
 
     return fd;
 }
@@ -179,6 +217,49 @@ unsigned char pk_bfskdemod_execute(pk_bfskdemod *fd, const float complex *sample
     return m > s;
 }
 
+// slide both correlators forward by one sample.
+//
+// the window sum against e^{-jwm} for absolute sample index m only
+// differs from the matched filter output by a constant phase, so the
+// magnitudes and the decision are the same as pk_bfskdemod_execute
+static unsigned char bfskdemod_slide(pk_bfskdemod *fd, float complex sample)
+{
+    float complex mark  = sample * fd->mark_rot;
+    float complex space = sample * fd->space_rot;
+
+    fd->mark_sum  += mark - fd->mark_prod[fd->pos];
+    fd->space_sum += space - fd->space_prod[fd->pos];
+    fd->mark_prod[fd->pos]  = mark;
+    fd->space_prod[fd->pos] = space;
+
+    fd->mark_rot  *= fd->mark_step;
+    fd->space_rot *= fd->space_step;
+
+    // once per window rebuild the sums from the stored products and
+    // renormalize the oscillators so rounding errors cannot accumulate
+    if (++fd->pos == fd->samp_sym) {
+        fd->pos = 0;
+        fd->mark_sum  = 0;
+        fd->space_sum = 0;
+
+        size_t i;
+        for (i = 0; i < fd->samp_sym; i++) {
+            fd->mark_sum  += fd->mark_prod[i];
+            fd->space_sum += fd->space_prod[i];
+        }
+
+        fd->mark_rot  /= cabsf(fd->mark_rot);
+        fd->space_rot /= cabsf(fd->space_rot);
+    }
+
+    // squared magnitudes give the same ordering without the square roots
+    float m = crealf(fd->mark_sum) * crealf(fd->mark_sum) + cimagf(fd->mark_sum) * cimagf(fd->mark_sum);
+    float s = crealf(fd->space_sum) * crealf(fd->space_sum) + cimagf(fd->space_sum) * cimagf(fd->space_sum);
+
+    fd->metric = m + s > 0 ? (m - s) / (m + s) : 0;
+    return m > s;
+}
+
 // process a batch of samples
 void pk_bfskdemod_process(
     pk_bfskdemod *fd,
@@ -187,17 +268,23 @@ void pk_bfskdemod_process(
 {
     pk_block_uu_clear(fd->data);
 
+    size_t max_bits = nrzi_max_bits(fd->samp_sym, num);
+    unsigned char *bits = pk_block_uu_begin_write(fd->data, max_bits);
+    float *soft = NULL;
+    size_t nbits = 0;
+
+    if (fd->soft) {
+        pk_block_ff_clear(fd->soft);
+        soft = pk_block_ff_begin_write(fd->soft, max_bits);
+    }
+
     size_t i;
     for (i = 0; i < num; i++) {
         fd->timer++;
 
-        float complex wb[fd->samp_sym];
         unsigned char match_filt;
 
-        pk_circ_cc_push(fd->window, input[i]);
-        pk_circ_cc_read(fd->window, wb, fd->samp_sym);
-
-        match_filt = pk_bfskdemod_execute(fd, wb);
+        match_filt = bfskdemod_slide(fd, input[i]);
 
         // adjust our timing based on the NRZI transitions
         if (match_filt != fd->past) {
@@ -208,12 +295,20 @@ void pk_bfskdemod_process(
 
         // make a bit decision and push it
         if (fd->timer >= 2*fd->samp_sym) {
-            unsigned char bit = fd->diff == 0;
-            pk_block_uu_push(fd->data, bit);
+            if (soft) {
+                soft[nbits] = nrzi_soft(fd->metric, fd->past_metric);
+                fd->past_metric = fd->metric;
+            }
+
+            bits[nbits++] = fd->diff == 0;
             fd->timer = fd->samp_sym;
             fd->diff = 0;
         }
     }
+
+    pk_block_uu_commit(fd->data, nbits);
+    if (soft)
+        pk_block_ff_commit(fd->soft, nbits);
 }
 
 // return a pointer to the output block of data
@@ -223,19 +318,201 @@ unsigned char *pk_bfskdemod_read(pk_bfskdemod *fd, size_t *nitems)
     return pk_block_uu_ptr(fd->data);
 }
 
+// enable or disable the soft decision output
+void pk_bfskdemod_set_soft(pk_bfskdemod *fd, int enable)
+{
+    if (enable && !fd->soft) {
+        fd->soft = pk_block_ff_create(1024);
+    } else if (!enable && fd->soft) {
+        pk_block_ff_destroy(fd->soft);
+        fd->soft = NULL;
+    }
+}
+
+// return a pointer to the soft decisions of the last batch
+float *pk_bfskdemod_read_soft(pk_bfskdemod *fd, size_t *nitems)
+{
+    if (!fd->soft) {
+        *nitems = 0;
+        return NULL;
+    }
+
+    *nitems = pk_block_ff_nitems(fd->soft);
+    return pk_block_ff_ptr(fd->soft);
+}
+
 // destroy the BFSK demodulator
 void pk_bfskdemod_destroy(pk_bfskdemod *fd)
 {
-    pk_circ_cc_destroy(fd->window);
+    pk_bfskdemod_set_soft(fd, 0);
     pk_block_uu_destroy(fd->data);
 
-    free(fd->mark_filt);
-    free(fd->space_filt);
+    pk_free(fd->mark_filt);
+    pk_free(fd->space_filt);
+    pk_free(fd->mark_prod);
+    pk_free(fd->space_prod);
 
-    free(fd);
+    pk_free(fd);
 }
 
 
+// Q15 fixed point BFSK demodulator for real input such as audio.
+// the correlator sums are exact integers, so unlike the float
+// version they never need to be rebuilt to stop drift
+#define BFSK_QQ_TABLE_BITS  10
+#define BFSK_QQ_TABLE_SIZE  (1 << BFSK_QQ_TABLE_BITS)
+
+typedef struct pk_bfskdemod_qq_s
+{
+    unsigned int samp_sym;
+
+    unsigned int diff;
+    unsigned int timer;
+    unsigned char past;
+
+    // Q15 sine table with an extra quarter for the cosine
+    int16_t *sine;
+    uint32_t mark_phase;
+    uint32_t space_phase;
+    uint32_t mark_inc;
+    uint32_t space_inc;
+
+    // Q30 products of the last samp_sym samples with each tone
+    size_t pos;
+    int32_t *mark_prod;
+    int32_t *space_prod;
+    int64_t sums[4];
+
+    pk_block_uu *data;
+} pk_bfskdemod_qq;
+
+pk_bfskdemod_qq *pk_bfskdemod_qq_create(
+    unsigned int samp_sym,   // samples per symbol
+    unsigned int baud,       // baud rate
+    float mark_freq,         // mark frequency  (1)
+    float space_freq)        // space frequency (0)
+{
+    pk_bfskdemod_qq *fd = pk_malloc(sizeof(pk_bfskdemod_qq));
+    fd->samp_sym = samp_sym;
+
+    fd->diff = 0;
+    fd->timer = 0;
+    fd->past = 0;
+
+    size_t i, len = BFSK_QQ_TABLE_SIZE + BFSK_QQ_TABLE_SIZE / 4;
+    fd->sine = pk_malloc(len * sizeof(int16_t));
+    for (i = 0; i < len; i++)
+        fd->sine[i] = pk_sat_q15(lrintf(32767.0f * sinf(2.0f * M_PI * i / BFSK_QQ_TABLE_SIZE)));
+
+    float samp_rate = fd->samp_sym * baud;
+    fd->mark_phase = 0;
+    fd->space_phase = 0;
+    fd->mark_inc  = (uint32_t) (mark_freq / samp_rate * 4294967296.0);
+    fd->space_inc = (uint32_t) (space_freq / samp_rate * 4294967296.0);
+
+    // the real and imaginary products are interleaved
+    fd->pos = 0;
+    fd->mark_prod  = pk_calloc(2 * fd->samp_sym, sizeof(int32_t));
+    fd->space_prod = pk_calloc(2 * fd->samp_sym, sizeof(int32_t));
+    for (i = 0; i < 4; i++)
+        fd->sums[i] = 0;
+
+    fd->data = pk_block_uu_create(1024);
+
+    return fd;
+}
+
+// multiply by e^{-j phase} and slide one of the correlators
+static void bfskdemod_qq_mix(
+    const int16_t *sine,
+    uint32_t phase,
+    int16_t sample,
+    int32_t *prod,
+    int64_t *sums)
+{
+    uint32_t idx = (phase + (1u << (31 - BFSK_QQ_TABLE_BITS))) >> (32 - BFSK_QQ_TABLE_BITS);
+
+    int32_t re =  sample * sine[idx + BFSK_QQ_TABLE_SIZE / 4];
+    int32_t im = -sample * sine[idx];
+
+    sums[0] += re - prod[0];
+    sums[1] += im - prod[1];
+    prod[0] = re;
+    prod[1] = im;
+}
+
+static unsigned char bfskdemod_qq_slide(pk_bfskdemod_qq *fd, int16_t sample)
+{
+    bfskdemod_qq_mix(fd->sine, fd->mark_phase, sample, fd->mark_prod + 2*fd->pos, fd->sums);
+    bfskdemod_qq_mix(fd->sine, fd->space_phase, sample, fd->space_prod + 2*fd->pos, fd->sums + 2);
+
+    fd->mark_phase += fd->mark_inc;
+    fd->space_phase += fd->space_inc;
+
+    if (++fd->pos == fd->samp_sym)
+        fd->pos = 0;
+
+    // drop back to Q15 before squaring so the energies fit in 64 bits
+    int64_t mr = fd->sums[0] >> 15, mi = fd->sums[1] >> 15;
+    int64_t sr = fd->sums[2] >> 15, si = fd->sums[3] >> 15;
+
+    return mr * mr + mi * mi > sr * sr + si * si;
+}
+
+// process a batch of Q15 samples
+void pk_bfskdemod_qq_process(
+    pk_bfskdemod_qq *fd,
+    const int16_t *input,
+    size_t num)
+{
+    pk_block_uu_clear(fd->data);
+
+    size_t max_bits = nrzi_max_bits(fd->samp_sym, num);
+    unsigned char *bits = pk_block_uu_begin_write(fd->data, max_bits);
+    size_t nbits = 0;
+
+    size_t i;
+    for (i = 0; i < num; i++) {
+        fd->timer++;
+
+        unsigned char match_filt = bfskdemod_qq_slide(fd, input[i]);
+
+        // adjust our timing based on the NRZI transitions
+        if (match_filt != fd->past) {
+            fd->diff = 1;
+            fd->past = match_filt;
+            fd->timer = fd->samp_sym / 2 + fd->samp_sym + 1;
+        }
+
+        // make a bit decision and push it
+        if (fd->timer >= 2*fd->samp_sym) {
+            bits[nbits++] = fd->diff == 0;
+            fd->timer = fd->samp_sym;
+            fd->diff = 0;
+        }
+    }
+
+    pk_block_uu_commit(fd->data, nbits);
+}
+
+// return a pointer to the output block of data
+unsigned char *pk_bfskdemod_qq_read(pk_bfskdemod_qq *fd, size_t *nitems)
+{
+    *nitems = pk_block_uu_nitems(fd->data);
+    return pk_block_uu_ptr(fd->data);
+}
+
+// destroy the Q15 BFSK demodulator
+void pk_bfskdemod_qq_destroy(pk_bfskdemod_qq *fd)
+{
+    pk_block_uu_destroy(fd->data);
+
+    pk_free(fd->sine);
+    pk_free(fd->mark_prod);
+    pk_free(fd->space_prod);
+    pk_free(fd);
+}
+
 /* FSK96 modem objects */
 typedef struct pk_fsk96mod_s
 {
@@ -247,7 +524,7 @@ typedef struct pk_fsk96mod_s
 pk_fsk96mod *pk_fsk96mod_create(
     unsigned int samp_sym)
 {
-    pk_fsk96mod *fm = malloc(sizeof(pk_fsk96mod));
+    pk_fsk96mod *fm = pk_malloc(sizeof(pk_fsk96mod));
     fm->samp_sym = samp_sym;
 
     fm->past = 0;
@@ -283,7 +560,7 @@ void pk_fsk96mod_process(
 // destroy the FSK96 modulator
 void pk_fsk96mod_destroy(pk_fsk96mod *fm)
 {
-    free(fm);
+    pk_free(fm);
 }
 
 typedef struct pk_fsk96demod_s
@@ -294,13 +571,22 @@ typedef struct pk_fsk96demod_s
     unsigned int timer;
     unsigned char past;
 
-    pk_circ_ff *window;
+    // moving sum over the last samp_sym samples
+    size_t pos;
+    float sum;
+    float *history;
+
+    // normalized integrator output at the last decision,
+    // for the optional soft output
+    float past_metric;
+    pk_block_ff *soft;
+
     pk_block_uu *data;
 } pk_fsk96demod;
 
 pk_fsk96demod *pk_fsk96demod_create(unsigned int samp_sym)
 {
-    pk_fsk96demod *fd = malloc(sizeof(pk_fsk96demod));
+    pk_fsk96demod *fd = pk_malloc(sizeof(pk_fsk96demod));
     fd->samp_sym = samp_sym;
 
     fd->data = pk_block_uu_create(1024);
@@ -309,13 +595,17 @@ pk_fsk96demod *pk_fsk96demod_create(unsigned int samp_sym)
     fd->timer = 0;
     fd->past = 0;
 
-    fd->window = pk_circ_ff_create(fd->samp_sym);
+    fd->soft = NULL;
+    fd->past_metric = 0;
+
+    fd->pos = 0;
+    fd->sum = 0;
+    fd->history = pk_calloc(fd->samp_sym, sizeof(float));
 
     return fd;
 }
 
 // execute on a symbol using integrate & dump filter
-// TODO: Improve this
 unsigned char pk_fsk96demod_execute(pk_fsk96demod *fd, const float *samples)
 {
     float result = 0;
@@ -327,6 +617,43 @@ unsigned char pk_fsk96demod_execute(pk_fsk96demod *fd, const float *samples)
     return result > 0;
 }
 
+// slide the integrator forward by one sample
+static unsigned char fsk96demod_slide(pk_fsk96demod *fd, float sample)
+{
+    fd->sum += sample - fd->history[fd->pos];
+    fd->history[fd->pos] = sample;
+
+    // once per window sum the history from scratch, oldest sample
+    // first, so rounding errors from the updates cannot accumulate
+    if (++fd->pos == fd->samp_sym) {
+        fd->pos = 0;
+        fd->sum = 0;
+
+        size_t i;
+        for (i = 0; i < fd->samp_sym; i++)
+            fd->sum += fd->history[i];
+    }
+
+    return fd->sum > 0;
+}
+
+// integrator output over the square root of samp_sym times the window
+// energy, which by Cauchy-Schwarz keeps it within -1..1
+static float fsk96demod_metric(pk_fsk96demod *fd)
+{
+    float energy = 0;
+
+    size_t i;
+    for (i = 0; i < fd->samp_sym; i++)
+        energy += fd->history[i] * fd->history[i];
+
+    if (energy <= 0)
+        return 0;
+
+    float metric = fd->sum / sqrtf(fd->samp_sym * energy);
+    return metric > 1 ? 1 : metric < -1 ? -1 : metric;
+}
+
 // process a batch of samples
 void pk_fsk96demod_process(
     pk_fsk96demod *fd,
@@ -335,17 +662,23 @@ void pk_fsk96demod_process(
 {
     pk_block_uu_clear(fd->data);
 
+    size_t max_bits = nrzi_max_bits(fd->samp_sym, num);
+    unsigned char *bits = pk_block_uu_begin_write(fd->data, max_bits);
+    float *soft = NULL;
+    size_t nbits = 0;
+
+    if (fd->soft) {
+        pk_block_ff_clear(fd->soft);
+        soft = pk_block_ff_begin_write(fd->soft, max_bits);
+    }
+
     size_t i;
     for (i = 0; i < num; i++) {
         fd->timer++;
 
-        float wb[fd->samp_sym];
         unsigned char match_filt;
 
-        pk_circ_ff_push(fd->window, samples[i]);
-        pk_circ_ff_read(fd->window, wb, fd->samp_sym);
-
-        match_filt = pk_fsk96demod_execute(fd, wb);
+        match_filt = fsk96demod_slide(fd, samples[i]);
 
         // adjust our timing
         if (match_filt != fd->past) {
@@ -356,12 +689,21 @@ void pk_fsk96demod_process(
 
         // make a bit decision and push it
         if (fd->timer >= 2*fd->samp_sym) {
-            unsigned char bit = fd->diff == 0;
-            pk_block_uu_push(fd->data, bit);
+            if (soft) {
+                float metric = fsk96demod_metric(fd);
+                soft[nbits] = nrzi_soft(metric, fd->past_metric);
+                fd->past_metric = metric;
+            }
+
+            bits[nbits++] = fd->diff == 0;
             fd->timer = fd->samp_sym;
             fd->diff = 0;
         }
     }
+
+    pk_block_uu_commit(fd->data, nbits);
+    if (soft)
+        pk_block_ff_commit(fd->soft, nbits);
 }
 
 // return a pointer to the output block of data
@@ -371,10 +713,438 @@ unsigned char *pk_fsk96demod_read(pk_fsk96demod *fd, size_t *nitems)
     return pk_block_uu_ptr(fd->data);
 }
 
+// enable or disable the soft decision output
+void pk_fsk96demod_set_soft(pk_fsk96demod *fd, int enable)
+{
+    if (enable && !fd->soft) {
+        fd->soft = pk_block_ff_create(1024);
+    } else if (!enable && fd->soft) {
+        pk_block_ff_destroy(fd->soft);
+        fd->soft = NULL;
+    }
+}
+
+// return a pointer to the soft decisions of the last batch
+float *pk_fsk96demod_read_soft(pk_fsk96demod *fd, size_t *nitems)
+{
+    if (!fd->soft) {
+        *nitems = 0;
+        return NULL;
+    }
+
+    *nitems = pk_block_ff_nitems(fd->soft);
+    return pk_block_ff_ptr(fd->soft);
+}
+
 void pk_fsk96demod_destroy(pk_fsk96demod *fd)
 {
-    pk_circ_ff_destroy(fd->window);
+    pk_fsk96demod_set_soft(fd, 0);
+    pk_block_uu_destroy(fd->data);
+
+    pk_free(fd->history);
+    pk_free(fd);
+}
+
+
+/* GMSK modem objects */
+// Gaussian MSK modulator. the phase change over a symbol only depends
+// on the last span bits, so the waveforms for every bit history are
+// precomputed and each symbol is a table read and a rotation
+typedef struct pk_gmskmod_s
+{
+    unsigned int samp_sym;
+    unsigned int span;
+    unsigned int history;
+    unsigned int mask;
+
+    // current carrier phase
+    float complex state;
+
+    // samp_sym samples per bit history, relative to the
+    // phase at the start of the symbol, and the end rotation
+    float complex *table;
+    float complex *rotation;
+} pk_gmskmod;
+
+// Gaussian filtered rectangular frequency pulse at t symbols from its center
+static float gmsk_pulse(float t, float bt)
+{
+    float k = 2.0f * M_PI * bt / sqrtf(M_LN2);
+
+    // difference of two Q functions, Q(x) = erfc(x / sqrt(2)) / 2
+    return 0.5f * (erfcf(k * (t - 0.5f) * M_SQRT1_2) - erfcf(k * (t + 0.5f) * M_SQRT1_2));
+}
+
+pk_gmskmod *pk_gmskmod_create(
+    unsigned int samp_sym,
+    float bt,
+    unsigned int span)
+{
+    if (span < 1 || span > 8) {
+        fprintf(stderr, "GMSK pulse span must be between 1 and 8 symbols!\n");
+        exit(1);
+    }
+
+    pk_gmskmod *fm = pk_malloc(sizeof(pk_gmskmod));
+    fm->samp_sym = samp_sym;
+    fm->span = span;
+    fm->history = 0;
+    fm->mask = (1u << span) - 1;
+    fm->state = 1;
+
+    size_t len = span * samp_sym;
+    float *pulse = pk_malloc(len * sizeof(float));
+
+    // sample the pulse centered in its span, scaled so
+    // that a bit moves the phase by pi / 2 in total
+    float total = 0;
+
+    size_t i;
+    for (i = 0; i < len; i++) {
+        float t = (i + 0.5f) / samp_sym - span / 2.0f;
+        pulse[i] = gmsk_pulse(t, bt);
+        total += pulse[i];
+    }
+
+    for (i = 0; i < len; i++)
+        pulse[i] *= (M_PI / 2.0f) / total;
+
+    fm->table = pk_malloc((fm->mask + 1) * samp_sym * sizeof(float complex));
+    fm->rotation = pk_malloc((fm->mask + 1) * sizeof(float complex));
+
+    // bit m of the history is the bit sent m symbols ago
+    unsigned int h;
+    for (h = 0; h <= fm->mask; h++) {
+        float phase = 0;
+
+        size_t n, m;
+        for (n = 0; n < samp_sym; n++) {
+            for (m = 0; m < span; m++) {
+                float a = (h >> m) & 1 ? 1.0f : -1.0f;
+                phase += a * pulse[m * samp_sym + n];
+            }
+            fm->table[h * samp_sym + n] = cexpf(I * phase);
+        }
+
+        fm->rotation[h] = cexpf(I * phase);
+    }
+
+    pk_free(pulse);
+
+    return fm;
+}
+
+// execute on a bit and produce a number of samples per symbol
+void pk_gmskmod_execute(pk_gmskmod *fm, float complex *sym, unsigned char bit)
+{
+    fm->history = ((fm->history << 1) | (bit & 1)) & fm->mask;
+
+    const float complex *wave = fm->table + fm->history * fm->samp_sym;
+
+    size_t i;
+    for (i = 0; i < fm->samp_sym; i++)
+        sym[i] = fm->state * wave[i];
+
+    // keep the carrier on the unit circle
+    fm->state *= fm->rotation[fm->history];
+    fm->state /= cabsf(fm->state);
+}
+
+// process a batch of bits
+void pk_gmskmod_process(
+    pk_gmskmod *fm,
+    float complex *output,
+    const unsigned char *input,
+    size_t num)
+{
+    size_t i;
+    for (i = 0; i < num; i++)
+        pk_gmskmod_execute(fm, &output[i*fm->samp_sym], input[i]);
+}
+
+// destroy the GMSK modulator
+void pk_gmskmod_destroy(pk_gmskmod *fm)
+{
+    pk_free(fm->table);
+    pk_free(fm->rotation);
+    pk_free(fm);
+}
+
+// GMSK demodulator. the phase change across one symbol is a matched
+// statistic for the bit, and the symbol timing loop lets it run
+// at a few samples per symbol
+typedef struct pk_gmskdemod_s
+{
+    unsigned int samp_sym;
+
+    // last samp_sym input samples for the differential detector
+    size_t pos;
+    float complex *delay;
+
+    pk_symsync *sync;
+
+    pk_block_ff *phase;
+    pk_block_ff *symbols;
+    pk_block_uu *data;
+} pk_gmskdemod;
+
+pk_gmskdemod *pk_gmskdemod_create(unsigned int samp_sym, float bandwidth)
+{
+    pk_gmskdemod *fd = pk_malloc(sizeof(pk_gmskdemod));
+    fd->samp_sym = samp_sym;
+
+    fd->pos = 0;
+    fd->delay = pk_calloc(samp_sym, sizeof(float complex));
+
+    fd->sync = pk_symsync_create(samp_sym, PK_SYMSYNC_GARDNER, bandwidth);
+
+    fd->phase = pk_block_ff_create(1024);
+    fd->symbols = pk_block_ff_create(1024);
+    fd->data = pk_block_uu_create(1024);
+
+    return fd;
+}
+
+// process a batch of samples
+void pk_gmskdemod_process(
+    pk_gmskdemod *fd,
+    const float complex *input,
+    size_t num)
+{
+    pk_block_ff_clear(fd->phase);
+    pk_block_ff_clear(fd->symbols);
+    pk_block_uu_clear(fd->data);
+
+    float *phase = pk_block_ff_begin_write(fd->phase, num);
+
+    size_t i;
+    for (i = 0; i < num; i++) {
+        // scaled so an isolated bit swings to +/- 1 for the timing loop
+        phase[i] = cargf(input[i] * conjf(fd->delay[fd->pos])) * (float) M_2_PI;
+
+        fd->delay[fd->pos] = input[i];
+        if (++fd->pos == fd->samp_sym)
+            fd->pos = 0;
+    }
+    pk_block_ff_commit(fd->phase, num);
+
+    float *symbols = pk_block_ff_begin_write(fd->symbols, num);
+    size_t nsym = pk_symsync_execute_real(fd->sync, symbols, phase, num);
+    pk_block_ff_commit(fd->symbols, nsym);
+
+    unsigned char *bits = pk_block_uu_begin_write(fd->data, nsym);
+    for (i = 0; i < nsym; i++)
+        bits[i] = symbols[i] > 0;
+    pk_block_uu_commit(fd->data, nsym);
+}
+
+// return a pointer to the output block of data
+unsigned char *pk_gmskdemod_read(pk_gmskdemod *fd, size_t *nitems)
+{
+    *nitems = pk_block_uu_nitems(fd->data);
+    return pk_block_uu_ptr(fd->data);
+}
+
+// destroy the GMSK demodulator
+void pk_gmskdemod_destroy(pk_gmskdemod *fd)
+{
+    pk_symsync_destroy(fd->sync);
+
+    pk_block_ff_destroy(fd->phase);
+    pk_block_ff_destroy(fd->symbols);
+    pk_block_uu_destroy(fd->data);
+
+    pk_free(fd->delay);
+    pk_free(fd);
+}
+
+
+/* QPSK and OQPSK modem objects */
+// rectangular pulse quadrature modulator, two bits per symbol with the
+// first on the in-phase arm. with offset set the quadrature arm is
+// delayed by half a symbol so the envelope never passes through zero
+typedef struct pk_oqpsk_mod_s
+{
+    unsigned int samp_sym;
+    int offset;
+
+    // quadrature level still being sent from the previous symbol
+    float past_q;
+} pk_oqpsk_mod;
+
+pk_oqpsk_mod *pk_oqpsk_mod_create(unsigned int samp_sym, int offset)
+{
+    if (samp_sym < 2 || samp_sym % 2) {
+        fprintf(stderr, "OQPSK needs an even number of samples per symbol!\n");
+        exit(1);
+    }
+
+    pk_oqpsk_mod *fm = pk_malloc(sizeof(pk_oqpsk_mod));
+    fm->samp_sym = samp_sym;
+    fm->offset = offset;
+    fm->past_q = 0;
+
+    return fm;
+}
+
+// execute on a pair of bits and produce samp_sym samples
+void pk_oqpsk_mod_execute(pk_oqpsk_mod *fm, float complex *sym, const unsigned char *bits)
+{
+    float i_level = bits[0] ? M_SQRT1_2 : -M_SQRT1_2;
+    float q_level = bits[1] ? M_SQRT1_2 : -M_SQRT1_2;
+
+    size_t half = fm->offset ? fm->samp_sym / 2 : 0;
+
+    size_t i;
+    for (i = 0; i < half; i++)
+        sym[i] = i_level + I * fm->past_q;
+    for (; i < fm->samp_sym; i++)
+        sym[i] = i_level + I * q_level;
+
+    fm->past_q = q_level;
+}
+
+// process a batch of bits, num is the number of bits and must be even
+void pk_oqpsk_mod_process(
+    pk_oqpsk_mod *fm,
+    float complex *output,
+    const unsigned char *input,
+    size_t num)
+{
+    size_t i;
+    for (i = 0; i < num / 2; i++)
+        pk_oqpsk_mod_execute(fm, &output[i*fm->samp_sym], &input[2*i]);
+}
+
+void pk_oqpsk_mod_destroy(pk_oqpsk_mod *fm)
+{
+    pk_free(fm);
+}
+
+// QPSK/OQPSK demodulator with a Costas loop and timing recovery. the
+// in-phase arm is delayed by half a symbol when offset so both arms line
+// up, then a rectangular matched filter feeds the symbol timing loop
+typedef struct pk_oqpsk_demod_s
+{
+    unsigned int samp_sym;
+
+    // delay of the in-phase arm in samples
+    unsigned int half;
+
+    // last samp_sym + half mixed samples for the matched filter
+    size_t pos;
+    float complex *line;
+
+    // scratch for one run of at most samp_sym samples
+    float complex *mixed;
+    float complex *matched;
+    float complex *symbols;
+
+    pk_costas *costas;
+    pk_symsync *sync;
+    pk_block_uu *data;
+} pk_oqpsk_demod;
+
+pk_oqpsk_demod *pk_oqpsk_demod_create(unsigned int samp_sym, int offset, float bandwidth)
+{
+    if (samp_sym < 2 || samp_sym % 2) {
+        fprintf(stderr, "OQPSK needs an even number of samples per symbol!\n");
+        exit(1);
+    }
+
+    pk_oqpsk_demod *fd = pk_malloc(sizeof(pk_oqpsk_demod));
+    fd->samp_sym = samp_sym;
+    fd->half = offset ? samp_sym / 2 : 0;
+
+    fd->pos = 0;
+    fd->line = pk_calloc(samp_sym + fd->half, sizeof(float complex));
+
+    fd->mixed = pk_malloc(samp_sym * sizeof(float complex));
+    fd->matched = pk_malloc(samp_sym * sizeof(float complex));
+    fd->symbols = pk_malloc(samp_sym * sizeof(float complex));
+
+    fd->costas = pk_costas_create(samp_sym, bandwidth);
+    fd->sync = pk_symsync_create(samp_sym, PK_SYMSYNC_GARDNER, bandwidth);
+    fd->data = pk_block_uu_create(1024);
+
+    return fd;
+}
+
+// process a batch of samples
+void pk_oqpsk_demod_process(
+    pk_oqpsk_demod *fd,
+    const float complex *input,
+    size_t num)
+{
+    pk_block_uu_clear(fd->data);
+
+    // the timing loop never spaces symbols closer than half a symbol
+    unsigned char *bits = pk_block_uu_begin_write(fd->data, 2 * (2 * num / fd->samp_sym + 1));
+    size_t nbits = 0;
+
+    size_t len = fd->samp_sym + fd->half;
+
+    size_t offset = 0;
+    while (offset < num) {
+        // the carrier estimate only moves once per symbol, so each
+        // symbol worth of samples is mixed in one go
+        size_t n = num - offset < fd->samp_sym ? num - offset : fd->samp_sym;
+        pk_costas_mix(fd->costas, fd->mixed, input + offset, n);
+
+        size_t i, k;
+        for (i = 0; i < n; i++) {
+            fd->line[fd->pos] = fd->mixed[i];
+            if (++fd->pos == len)
+                fd->pos = 0;
+
+            // average one symbol of each arm, the in-phase arm
+            // taken half a symbol further back
+            float re = 0, im = 0;
+            size_t q = fd->pos + len - 1;
+            for (k = 0; k < fd->samp_sym; k++, q--) {
+                re += crealf(fd->line[(q - fd->half) % len]);
+                im += cimagf(fd->line[q % len]);
+            }
+
+            fd->matched[i] = (re + I * im) / fd->samp_sym;
+        }
+
+        size_t nsym = pk_symsync_execute(fd->sync, fd->symbols, fd->matched, n);
+        for (i = 0; i < nsym; i++) {
+            pk_costas_update(fd->costas, fd->symbols[i]);
+
+            bits[nbits++] = crealf(fd->symbols[i]) > 0;
+            bits[nbits++] = cimagf(fd->symbols[i]) > 0;
+        }
+
+        offset += n;
+    }
+
+    pk_block_uu_commit(fd->data, nbits);
+}
+
+// return a pointer to the output block of data
+unsigned char *pk_oqpsk_demod_read(pk_oqpsk_demod *fd, size_t *nitems)
+{
+    *nitems = pk_block_uu_nitems(fd->data);
+    return pk_block_uu_ptr(fd->data);
+}
+
+// current carrier frequency estimate in radians per sample
+float pk_oqpsk_demod_get_frequency(pk_oqpsk_demod *fd)
+{
+    return pk_costas_get_frequency(fd->costas);
+}
+
+void pk_oqpsk_demod_destroy(pk_oqpsk_demod *fd)
+{
+    pk_costas_destroy(fd->costas);
+    pk_symsync_destroy(fd->sync);
     pk_block_uu_destroy(fd->data);
 
-    free(fd);
+    pk_free(fd->line);
+    pk_free(fd->mixed);
+    pk_free(fd->matched);
+    pk_free(fd->symbols);
+    pk_free(fd);
 }
@@ -21,3 +21,288 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
  * THE SOFTWARE.
  */
+
+#include "plancki.h"
+
+#if defined(PK_X86_SIMD)
+#include <immintrin.h>
+#endif
+
+/* Numerically controlled oscillator */
+// the phase is a 32 bit fixed point fraction of a full turn,
+// the top NCO_TABLE_BITS bits index a quarter-extended sine table
+// so the cosine is the same lookup offset by a quarter turn
+#define NCO_TABLE_BITS  10
+#define NCO_TABLE_SIZE  (1 << NCO_TABLE_BITS)
+#define NCO_QUARTER     (NCO_TABLE_SIZE / 4)
+#define NCO_FRAC_BITS   (32 - NCO_TABLE_BITS)
+#define NCO_FRAC_MASK   ((1u << NCO_FRAC_BITS) - 1)
+#define NCO_FRAC_SCALE  (1.0f / (float) (1u << NCO_FRAC_BITS))
+
+// samples looked up at once before being combined
+#define NCO_CHUNK       64
+
+// fills cos and sin for num phases starting at phase
+typedef void (*nco_lookup_kernel)(
+    const float *table,
+    uint32_t phase,
+    uint32_t inc,
+    int interp,
+    float *c,
+    float *s,
+    size_t num);
+
+typedef struct pk_nco_s
+{
+    uint32_t phase;
+    uint32_t inc;
+    int interp;
+
+    const float *table;
+    nco_lookup_kernel lookup;
+} pk_nco;
+
+// one extra quarter for the cosine and a guard entry for interpolation,
+// every oscillator reads the same table so it is only filled once
+static float nco_table[NCO_TABLE_SIZE + NCO_QUARTER + 1];
+static int nco_table_ready = 0;
+
+static void nco_table_init(void)
+{
+    if (nco_table_ready)
+        return;
+
+    size_t i;
+    for (i = 0; i < NCO_TABLE_SIZE + NCO_QUARTER + 1; i++)
+        nco_table[i] = sinf(2.0f * M_PI * i / NCO_TABLE_SIZE);
+
+    nco_table_ready = 1;
+}
+
+// convert radians into the nearest fraction of a turn, negative values
+// wrap around so small corrections in either direction stay unbiased
+static uint32_t nco_radians(float rad)
+{
+    double turns = rad / (2.0 * M_PI);
+    turns -= floor(turns);
+
+    // a full turn rounds back around to zero
+    return (uint32_t) (int64_t) llround(turns * 4294967296.0);
+}
+
+static void nco_lookup_scalar(
+    const float *table,
+    uint32_t phase,
+    uint32_t inc,
+    int interp,
+    float *c,
+    float *s,
+    size_t num)
+{
+    size_t i;
+    if (interp) {
+        for (i = 0; i < num; i++, phase += inc) {
+            uint32_t idx = phase >> NCO_FRAC_BITS;
+            float frac = (phase & NCO_FRAC_MASK) * NCO_FRAC_SCALE;
+
+            s[i] = table[idx] + frac * (table[idx + 1] - table[idx]);
+            c[i] = table[idx + NCO_QUARTER]
+                 + frac * (table[idx + NCO_QUARTER + 1] - table[idx + NCO_QUARTER]);
+        }
+    } else {
+        for (i = 0; i < num; i++, phase += inc) {
+            // round to the nearest table entry
+            uint32_t idx = (phase + (1u << (NCO_FRAC_BITS - 1))) >> NCO_FRAC_BITS;
+
+            s[i] = table[idx];
+            c[i] = table[idx + NCO_QUARTER];
+        }
+    }
+}
+
+#if defined(PK_X86_SIMD)
+PK_TARGET("avx2")
+static void nco_lookup_avx2(
+    const float *table,
+    uint32_t phase,
+    uint32_t inc,
+    int interp,
+    float *c,
+    float *s,
+    size_t num)
+{
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i quarter = _mm256_set1_epi32(NCO_QUARTER);
+    const __m256i one = _mm256_set1_epi32(1);
+
+    __m256i p = _mm256_add_epi32(_mm256_set1_epi32((int) phase),
+                                 _mm256_mullo_epi32(_mm256_set1_epi32((int) inc), lanes));
+    __m256i step = _mm256_set1_epi32((int) (inc * 8));
+
+    size_t i = 0;
+    if (interp) {
+        const __m256i mask = _mm256_set1_epi32(NCO_FRAC_MASK);
+        const __m256 scale = _mm256_set1_ps(NCO_FRAC_SCALE);
+
+        for (; i + 8 <= num; i += 8) {
+            __m256i idx = _mm256_srli_epi32(p, NCO_FRAC_BITS);
+            __m256 frac = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(p, mask)), scale);
+
+            __m256i cidx = _mm256_add_epi32(idx, quarter);
+            __m256 s0 = _mm256_i32gather_ps(table, idx, 4);
+            __m256 s1 = _mm256_i32gather_ps(table, _mm256_add_epi32(idx, one), 4);
+            __m256 c0 = _mm256_i32gather_ps(table, cidx, 4);
+            __m256 c1 = _mm256_i32gather_ps(table, _mm256_add_epi32(cidx, one), 4);
+
+            _mm256_storeu_ps(s + i, _mm256_add_ps(s0, _mm256_mul_ps(frac, _mm256_sub_ps(s1, s0))));
+            _mm256_storeu_ps(c + i, _mm256_add_ps(c0, _mm256_mul_ps(frac, _mm256_sub_ps(c1, c0))));
+
+            p = _mm256_add_epi32(p, step);
+        }
+    } else {
+        const __m256i half = _mm256_set1_epi32(1 << (NCO_FRAC_BITS - 1));
+
+        for (; i + 8 <= num; i += 8) {
+            __m256i idx = _mm256_srli_epi32(_mm256_add_epi32(p, half), NCO_FRAC_BITS);
+
+            _mm256_storeu_ps(s + i, _mm256_i32gather_ps(table, idx, 4));
+            _mm256_storeu_ps(c + i, _mm256_i32gather_ps(table, _mm256_add_epi32(idx, quarter), 4));
+
+            p = _mm256_add_epi32(p, step);
+        }
+    }
+
+    nco_lookup_scalar(table, phase + (uint32_t) i * inc, inc, interp, c + i, s + i, num - i);
+}
+#endif
+
+static nco_lookup_kernel nco_lookup_select(void)
+{
+#if defined(PK_X86_SIMD)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return nco_lookup_avx2;
+#endif
+    return nco_lookup_scalar;
+}
+
+// create an oscillator running at freq radians per sample,
+// interp enables linear interpolation between table entries
+pk_nco *pk_nco_create(float freq, int interp)
+{
+    pk_nco *nco = pk_malloc(sizeof(pk_nco));
+    nco->phase = 0;
+    nco->inc = nco_radians(freq);
+    nco->interp = interp;
+
+    nco_table_init();
+    nco->table = nco_table;
+
+    nco->lookup = nco_lookup_select();
+
+    return nco;
+}
+
+void pk_nco_set_frequency(pk_nco *nco, float freq)
+{
+    nco->inc = nco_radians(freq);
+}
+
+void pk_nco_adjust_frequency(pk_nco *nco, float dfreq)
+{
+    nco->inc += nco_radians(dfreq);
+}
+
+void pk_nco_set_phase(pk_nco *nco, float phase)
+{
+    nco->phase = nco_radians(phase);
+}
+
+void pk_nco_adjust_phase(pk_nco *nco, float dphase)
+{
+    nco->phase += nco_radians(dphase);
+}
+
+float pk_nco_get_frequency(pk_nco *nco)
+{
+    // report negative frequencies for increments past half a turn
+    return (int32_t) nco->inc * (float) (2.0 * M_PI / 4294967296.0);
+}
+
+float pk_nco_get_phase(pk_nco *nco)
+{
+    return nco->phase * (float) (2.0 * M_PI / 4294967296.0);
+}
+
+// generate num samples of e^{j phase}, advancing the phase after each
+void pk_nco_generate(pk_nco *nco, float complex *output, size_t num)
+{
+    float c[NCO_CHUNK];
+    float s[NCO_CHUNK];
+
+    while (num > 0) {
+        size_t n = num < NCO_CHUNK ? num : NCO_CHUNK;
+        nco->lookup(nco->table, nco->phase, nco->inc, nco->interp, c, s, n);
+        nco->phase += (uint32_t) n * nco->inc;
+
+        size_t i;
+        for (i = 0; i < n; i++)
+            output[i] = c[i] + I * s[i];
+
+        output += n;
+        num -= n;
+    }
+}
+
+// shift the input up by the oscillator frequency
+void pk_nco_mix_up(pk_nco *nco, float complex *output, const float complex *input, size_t num)
+{
+    float c[NCO_CHUNK];
+    float s[NCO_CHUNK];
+
+    while (num > 0) {
+        size_t n = num < NCO_CHUNK ? num : NCO_CHUNK;
+        nco->lookup(nco->table, nco->phase, nco->inc, nco->interp, c, s, n);
+        nco->phase += (uint32_t) n * nco->inc;
+
+        size_t i;
+        for (i = 0; i < n; i++) {
+            float re = crealf(input[i]);
+            float im = cimagf(input[i]);
+            output[i] = (re * c[i] - im * s[i]) + I * (re * s[i] + im * c[i]);
+        }
+
+        input += n;
+        output += n;
+        num -= n;
+    }
+}
+
+// shift the input down by the oscillator frequency
+void pk_nco_mix_down(pk_nco *nco, float complex *output, const float complex *input, size_t num)
+{
+    float c[NCO_CHUNK];
+    float s[NCO_CHUNK];
+
+    while (num > 0) {
+        size_t n = num < NCO_CHUNK ? num : NCO_CHUNK;
+        nco->lookup(nco->table, nco->phase, nco->inc, nco->interp, c, s, n);
+        nco->phase += (uint32_t) n * nco->inc;
+
+        size_t i;
+        for (i = 0; i < n; i++) {
+            float re = crealf(input[i]);
+            float im = cimagf(input[i]);
+            output[i] = (re * c[i] + im * s[i]) + I * (im * c[i] - re * s[i]);
+        }
+
+        input += n;
+        output += n;
+        num -= n;
+    }
+}
+
+void pk_nco_destroy(pk_nco *nco)
+{
+    pk_free(nco);
+}
@@ -38,7 +38,7 @@ pk_add_scrambler *pk_add_scrambler_create(unsigned int n, uint32_t start)
         exit(1);
     }
 
-    pk_add_scrambler *as = malloc(sizeof(pk_add_scrambler));
+    pk_add_scrambler *as = pk_malloc(sizeof(pk_add_scrambler));
 
     as->lfsr = pk_lfsr_create(n, start);
 
@@ -51,20 +51,36 @@ unsigned char pk_add_scrambler_execute(pk_add_scrambler *as, unsigned char input
     return (state + input) & 1;
 }
 
+uint64_t pk_add_scrambler_execute_word(pk_add_scrambler *as, uint64_t input, unsigned int num)
+{
+    uint64_t mask = num == 64 ? ~(uint64_t) 0 : ((uint64_t) 1 << num) - 1;
+    return (pk_lfsr_execute_word(as->lfsr, num, NULL) ^ input) & mask;
+}
+
+void pk_add_scrambler_jump(pk_add_scrambler *as, size_t num)
+{
+    pk_lfsr_jump(as->lfsr, num, NULL);
+}
+
 void pk_add_scrambler_destroy(pk_add_scrambler *as)
 {
     pk_lfsr_destroy(as->lfsr);
 
-    free(as);
+    pk_free(as);
 }
 
 /* arbitrary multiplicative data scrambler */
-// has a corresponding descrambler with slightly different structure
+// has a corresponding descrambler with slightly different structure.
+// the output bits feed back like a reflected CRC, so a byte of input
+// xored into the state indexes the next state and the output byte
 typedef struct pk_mult_scrambler_s
 {
     uint32_t start;
     uint32_t state;
     uint32_t poly;
+
+    uint32_t next[256];
+    unsigned char out[256];
 } pk_mult_scrambler;
 
 pk_mult_scrambler *pk_mult_scrambler_create(unsigned int n, uint32_t start)
@@ -74,12 +90,28 @@ pk_mult_scrambler *pk_mult_scrambler_create(unsigned int n, uint32_t start)
         exit(1);
     }
 
-    pk_mult_scrambler *ms = malloc(sizeof(pk_mult_scrambler));
+    pk_mult_scrambler *ms = pk_malloc(sizeof(pk_mult_scrambler));
 
     ms->start = start;
     ms->state = start;
     ms->poly = lfsr_poly_tab[19 - n] >> 1;
 
+    unsigned int byte, i;
+    for (byte = 0; byte < 256; byte++) {
+        uint32_t state = byte;
+        unsigned char out = 0;
+
+        for (i = 0; i < 8; i++) {
+            uint32_t bit = state & 1;
+            state >>= 1;
+            state ^= ms->poly & -bit;
+            out |= bit << i;
+        }
+
+        ms->next[byte] = state;
+        ms->out[byte] = out;
+    }
+
     return ms;
 }
 
@@ -92,17 +124,47 @@ unsigned char pk_mult_scrambler_execute(pk_mult_scrambler *ms, unsigned char inp
     return bit;
 }
 
+uint64_t pk_mult_scrambler_execute_word(pk_mult_scrambler *ms, uint64_t input, unsigned int num)
+{
+    assert(num <= 64);
+
+    uint64_t word = 0;
+    uint32_t state = ms->state;
+
+    unsigned int i;
+    for (i = 0; i + 8 <= num; i += 8) {
+        unsigned int x = (state ^ (input >> i)) & 0xff;
+        word |= (uint64_t) ms->out[x] << i;
+        state = (state >> 8) ^ ms->next[x];
+    }
+
+    for (; i < num; i++) {
+        uint32_t bit = (state ^ (input >> i)) & 1;
+        state >>= 1;
+        state ^= ms->poly & -bit;
+        word |= (uint64_t) bit << i;
+    }
+
+    ms->state = state;
+    return word;
+}
+
 void pk_mult_scrambler_destroy(pk_mult_scrambler *ms)
 {
-    free(ms);
+    pk_free(ms);
 }
 
 /* arbitrary multiplicative data descrambler */
+// the input bits feed back, so a byte of input indexes what it adds to
+// the state and to the output, and the old state only shifts through
 typedef struct pk_mult_descrambler_s
 {
     uint32_t start;
     uint32_t state;
     uint32_t poly;
+
+    uint32_t next[256];
+    unsigned char out[256];
 } pk_mult_descrambler;
 
 pk_mult_descrambler *pk_mult_descrambler_create(unsigned int n, uint32_t start)
@@ -112,12 +174,28 @@ pk_mult_descrambler *pk_mult_descrambler_create(unsigned int n, uint32_t start)
         exit(1);
     }
 
-    pk_mult_descrambler *md = malloc(sizeof(pk_mult_descrambler));
+    pk_mult_descrambler *md = pk_malloc(sizeof(pk_mult_descrambler));
 
     md->start = start;
     md->state = start;
     md->poly = lfsr_poly_tab[19 - n] >> 1;
 
+    unsigned int byte, i;
+    for (byte = 0; byte < 256; byte++) {
+        uint32_t state = 0;
+        unsigned char out = 0;
+
+        for (i = 0; i < 8; i++) {
+            uint32_t bit = (byte >> i) & 1;
+            out |= ((bit ^ state) & 1) << i;
+            state >>= 1;
+            state ^= md->poly & -bit;
+        }
+
+        md->next[byte] = state;
+        md->out[byte] = out;
+    }
+
     return md;
 }
 
@@ -131,7 +209,32 @@ unsigned char pk_mult_descrambler_execute(pk_mult_descrambler *md, unsigned char
     return out;
 }
 
+uint64_t pk_mult_descrambler_execute_word(pk_mult_descrambler *md, uint64_t input, unsigned int num)
+{
+    assert(num <= 64);
+
+    uint64_t word = 0;
+    uint32_t state = md->state;
+
+    unsigned int i;
+    for (i = 0; i + 8 <= num; i += 8) {
+        unsigned int x = (input >> i) & 0xff;
+        word |= (uint64_t) (md->out[x] ^ (state & 0xff)) << i;
+        state = (state >> 8) ^ md->next[x];
+    }
+
+    for (; i < num; i++) {
+        uint32_t bit = (input >> i) & 1;
+        word |= (uint64_t) ((bit ^ state) & 1) << i;
+        state >>= 1;
+        state ^= md->poly & -bit;
+    }
+
+    md->state = state;
+    return word;
+}
+
 void pk_mult_descrambler_destroy(pk_mult_descrambler *md)
 {
-    free(md);
+    pk_free(md);
 }
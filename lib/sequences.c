@@ -25,12 +25,25 @@
 #include "plancki.h"
 
 /* Maximal LFSR generator */
+// a byte of steps is one table lookup, next holds the state reached
+// from the low byte alone and out the low bit after each of the steps.
+// the rest of the state only shifts down and reaches the low bit on
+// the last step
 typedef struct pk_lfsr_s
 {
+    unsigned int n;
     uint32_t start;
     uint32_t state;
     uint32_t poly;
     size_t p;
+
+    // steps before the start state comes back, zero if it never does.
+    // only the word and jump calls need it, so it is found on first use
+    int has_period;
+    size_t period;
+
+    uint32_t next[256];
+    unsigned char out[256];
 } pk_lfsr;
 
 pk_lfsr *pk_lfsr_create(unsigned int n, uint32_t start)
@@ -40,13 +53,33 @@ pk_lfsr *pk_lfsr_create(unsigned int n, uint32_t start)
         exit(1);
     }
 
-    pk_lfsr *l = malloc(sizeof(pk_lfsr));
+    pk_lfsr *l = pk_malloc(sizeof(pk_lfsr));
 
     l->p = 0;
     l->start = start;
     l->state = start;
     l->poly  = lfsr_poly_tab[19 - n] >> 1;
 
+    l->n = n;
+    l->has_period = 0;
+    l->period = 0;
+
+    unsigned int byte, i;
+    for (byte = 0; byte < 256; byte++) {
+        uint32_t state = byte;
+        unsigned char out = 0;
+
+        for (i = 0; i < 8; i++) {
+            uint32_t bit = state & 1;
+            state >>= 1;
+            state ^= l->poly & -bit;
+            out |= (state & 1) << i;
+        }
+
+        l->next[byte] = state;
+        l->out[byte] = out;
+    }
+
     return l;
 }
 
@@ -66,7 +99,123 @@ uint32_t pk_lfsr_execute(pk_lfsr *l, int *out_period)
     return l->state;
 }
 
+// not every polynomial in the table is maximal, so walk the cycle once.
+// a start state wider than n bits is shifted out and never comes back
+static size_t lfsr_period(pk_lfsr *l)
+{
+    if (l->has_period)
+        return l->period;
+
+    l->has_period = 1;
+    if (l->start != 0 && (l->start >> l->n) == 0) {
+        uint32_t state = l->start;
+        do {
+            uint32_t bit = state & 1;
+            state >>= 1;
+            state ^= l->poly & -bit;
+            l->period++;
+        } while (state != l->start);
+    }
+
+    return l->period;
+}
+
+// the state only comes back to start after a full cycle
+static void lfsr_advance_period(pk_lfsr *l, size_t num)
+{
+    if (l->start == 0)
+        l->p = 0;
+    else if (lfsr_period(l) == 0)
+        l->p += num;
+    else
+        l->p = (l->p + num % l->period) % l->period;
+}
+
+uint64_t pk_lfsr_execute_word(pk_lfsr *l, unsigned int num, int *out_period)
+{
+    assert(num <= 64);
+
+    uint64_t word = 0;
+    uint32_t state = l->state;
+
+    unsigned int i;
+    for (i = 0; i + 8 <= num; i += 8) {
+        unsigned int low = state & 0xff;
+        uint64_t out = l->out[low] ^ ((state >> 1) & 0x80);
+
+        word |= out << i;
+        state = (state >> 8) ^ l->next[low];
+    }
+
+    for (; i < num; i++) {
+        uint32_t bit = state & 1;
+        state >>= 1;
+        state ^= l->poly & -bit;
+        word |= (uint64_t) (state & 1) << i;
+    }
+
+    l->state = state;
+    lfsr_advance_period(l, num);
+
+    if (out_period != NULL)
+        *out_period = l->p;
+
+    return word;
+}
+
+// columns of the state transition matrix over GF(2), column j is
+// where a single set bit j goes after one step
+#define LFSR_BITS 32
+
+static uint32_t lfsr_apply(const uint32_t *m, uint32_t v)
+{
+    uint32_t r = 0;
+
+    unsigned int j;
+    for (j = 0; v; j++, v >>= 1)
+        r ^= m[j] & -(v & 1);
+
+    return r;
+}
+
+// step num times with one matrix product per bit of num
+uint32_t pk_lfsr_jump(pk_lfsr *l, size_t num, int *out_period)
+{
+    uint32_t m[LFSR_BITS];
+    uint32_t sq[LFSR_BITS];
+
+    unsigned int j;
+    for (j = 0; j < LFSR_BITS; j++)
+        m[j] = (((uint32_t) 1 << j) >> 1) ^ (l->poly & -(uint32_t) (j == 0));
+
+    lfsr_advance_period(l, num);
+
+    // the state is on its cycle, so whole cycles can be skipped
+    if (l->period != 0)
+        num %= l->period;
+
+    uint32_t state = l->state;
+    while (num) {
+        if (num & 1)
+            state = lfsr_apply(m, state);
+
+        num >>= 1;
+        if (num) {
+            for (j = 0; j < LFSR_BITS; j++)
+                sq[j] = lfsr_apply(m, m[j]);
+            memcpy(m, sq, sizeof(m));
+        }
+    }
+
+    l->state = state;
+
+    if (out_period != NULL)
+        *out_period = l->p;
+
+    return l->state;
+}
+
 void pk_lfsr_destroy(pk_lfsr *l)
 {
-    free(l);
+    pk_free(l);
 }
@@ -0,0 +1,93 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Paul Uri David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "common.h"
+
+#include <stdint.h>
+
+typedef struct
+{
+    size_t allocs;
+    size_t frees;
+    size_t align;
+} alloc_stats;
+
+static void *counting_alloc(size_t size, size_t align, void *ctx)
+{
+    alloc_stats *stats = ctx;
+    stats->allocs++;
+    stats->align = align;
+
+    size = (size + align - 1) & ~(align - 1);
+    return aligned_alloc(align, size);
+}
+
+static void counting_free(void *ptr, void *ctx)
+{
+    alloc_stats *stats = ctx;
+    stats->frees++;
+    free(ptr);
+}
+
+int test_allocator_hooks()
+{
+    alloc_stats stats = {0, 0, 0};
+    pk_set_allocator(counting_alloc, counting_free, &stats);
+
+    float coeff[33] = {1.0f};
+    pk_fir_ff *fir = pk_fir_ff_create(32, coeff);
+    pk_fftfilt_cc *fft = pk_fftfilt_cc_create(32, 0, (pk_complex[33]) {1.0f});
+    pk_block_ff *block = pk_block_ff_create(4);
+
+    size_t i;
+    for (i = 0; i < 100; i++)
+        pk_block_ff_push(block, (float) i);
+
+    // sample storage must be ready for aligned vector loads
+    if (((uintptr_t) pk_block_ff_ptr(block) & 63) != 0)
+        return FAIL;
+
+    pk_block_ff_destroy(block);
+    pk_fftfilt_cc_destroy(fft);
+    pk_fir_ff_destroy(fir);
+
+    pk_set_allocator(NULL, NULL, NULL);
+
+    if (stats.allocs == 0 || stats.allocs != stats.frees || stats.align < 64)
+        return FAIL;
+
+    printf("test_allocator_hooks passed.\n");
+    return PASS;
+}
+
+int main(int argc, char *argv[])
+{
+    int result = PASS;
+
+    // run all of the tests
+    result += test_allocator_hooks();
+
+    printf("all allocator tests finished.\n");
+    return result;
+}
@@ -24,6 +24,9 @@
 
 #include "common.h"
 
+#include <pthread.h>
+#include <sched.h>
+
 int test_buffer_fill()
 {
     // generate random bits
@@ -163,6 +166,43 @@ int test_buffer_read()
     return PASS;
 }
 
+int test_buffer_append_view()
+{
+    int items[40];
+
+    size_t i;
+    for (i = 0; i < 40; i++)
+        items[i] = (int) i;
+
+    pk_circ_ii *pushed = pk_circ_ii_create(12);
+    pk_circ_ii *appended = pk_circ_ii_create(12);
+
+    for (i = 0; i < 40; i++)
+        pk_circ_ii_push(pushed, items[i]);
+
+    pk_circ_ii_append(appended, items, 3);
+    pk_circ_ii_append(appended, items + 3, 37);
+
+    // the view holds the latest items, oldest first
+    const int *view = pk_circ_ii_view(appended);
+    for (i = 0; i < 12; i++) {
+        if (view[i] != items[28 + i])
+            return FAIL;
+    }
+
+    if (memcmp(view, pk_circ_ii_view(pushed), 12 * sizeof(int)) != 0)
+        return FAIL;
+
+    if (pk_circ_ii_pop(appended) != 39 || pk_circ_ii_pop(pushed) != 39)
+        return FAIL;
+
+    pk_circ_ii_destroy(pushed);
+    pk_circ_ii_destroy(appended);
+
+    printf("test_buffer_append_view passed.\n");
+    return PASS;
+}
+
 int test_block_read()
 {
     // generate random bits
@@ -197,6 +237,48 @@ int test_block_read()
     return PASS;
 }
 
+int test_block_append_commit()
+{
+    int input[100];
+
+    size_t i;
+    for (i = 0; i < 100; i++)
+        input[i] = (int) i;
+
+    pk_block_ii *block = pk_block_ii_create(4);
+
+    // grows past the initial capacity
+    pk_block_ii_append(block, input, 50);
+
+    int *out = pk_block_ii_begin_write(block, 50);
+    if (pk_block_ii_size(block) < 100)
+        return FAIL;
+
+    // write in place, only commit part of the reservation
+    for (i = 0; i < 30; i++)
+        out[i] = input[50 + i];
+    pk_block_ii_commit(block, 30);
+
+    for (i = 80; i < 100; i++)
+        pk_block_ii_push(block, input[i]);
+
+    if (pk_block_ii_nitems(block) != 100)
+        return FAIL;
+
+    out = pk_block_ii_ptr(block);
+    for (i = 0; i < 100; i++) {
+        if (out[i] != input[i]) {
+            pk_block_ii_destroy(block);
+            return FAIL;
+        }
+    }
+
+    pk_block_ii_destroy(block);
+
+    printf("test_block_append_commit passed.\n");
+    return PASS;
+}
+
 int test_queue_read()
 {
     // generate random bits
@@ -262,6 +344,158 @@ int test_queue_partial_read()
     return PASS;
 }
 
+int test_queue_append_wrap()
+{
+    int items[100];
+
+    size_t i;
+    for (i = 0; i < 100; i++)
+        items[i] = (int) i;
+
+    pk_queue_ii *queue = pk_queue_ii_create();
+    pk_queue_ii_reserve(queue, 8);
+
+    // move the front so later growth has to unwrap the items
+    pk_queue_ii_append(queue, items, 10);
+    for (i = 0; i < 7; i++)
+        pk_queue_ii_dequeue(queue);
+
+    pk_queue_ii_append(queue, items + 10, 20);
+    for (i = 30; i < 100; i++)
+        pk_queue_ii_insert(queue, items[i]);
+
+    if (pk_queue_ii_nitems(queue) != 93)
+        return FAIL;
+
+    int out[93];
+    pk_queue_ii_read(queue, out, 0);
+
+    for (i = 0; i < 93; i++) {
+        if (out[i] != items[7 + i]) {
+            pk_queue_ii_destroy(queue);
+            return FAIL;
+        }
+    }
+
+    pk_queue_ii_destroy(queue);
+
+    printf("test_queue_append_wrap passed.\n");
+    return PASS;
+}
+
+int test_ring_wrap()
+{
+    int input[100];
+    int output[100];
+
+    size_t i;
+    for (i = 0; i < 100; i++)
+        input[i] = (int) i;
+
+    pk_ring_ii *ring = pk_ring_ii_create(12);
+
+    if (pk_ring_ii_size(ring) != 16)
+        return FAIL;
+
+    // a full ring only accepts what fits
+    if (pk_ring_ii_write(ring, input, 20) != 16 || pk_ring_ii_space(ring) != 0)
+        return FAIL;
+
+    if (pk_ring_ii_read(ring, output, 10) != 10 || pk_ring_ii_nitems(ring) != 6)
+        return FAIL;
+
+    // wrap around the end of the storage
+    if (pk_ring_ii_write(ring, input + 16, 10) != 10)
+        return FAIL;
+
+    if (pk_ring_ii_read(ring, output + 10, 100) != 16)
+        return FAIL;
+
+    if (pk_ring_ii_read(ring, output, 1) != 0)
+        return FAIL;
+
+    for (i = 0; i < 26; i++) {
+        if (output[i] != input[i]) {
+            pk_ring_ii_destroy(ring);
+            return FAIL;
+        }
+    }
+
+    pk_ring_ii_destroy(ring);
+
+    printf("test_ring_wrap passed.\n");
+    return PASS;
+}
+
+#define RING_THREAD_ITEMS 200000
+
+// writes 0, 1, 2, ... in uneven chunks, yielding while the ring is full
+static void *ring_producer(void *arg)
+{
+    pk_ring_ii *ring = arg;
+    int chunk[37];
+
+    int next = 0;
+    size_t n = 1;
+    while (next < RING_THREAD_ITEMS) {
+        size_t i, num = n;
+        if (num > (size_t) (RING_THREAD_ITEMS - next))
+            num = RING_THREAD_ITEMS - next;
+
+        for (i = 0; i < num; i++)
+            chunk[i] = next + (int) i;
+
+        size_t written = pk_ring_ii_write(ring, chunk, num);
+        if (written == 0)
+            sched_yield();
+
+        next += (int) written;
+        n = n % 37 + 1;
+    }
+
+    return NULL;
+}
+
+int test_ring_threads()
+{
+    // a small ring keeps both sides wrapping and meeting often
+    pk_ring_ii *ring = pk_ring_ii_create(64);
+
+    pthread_t producer;
+    if (pthread_create(&producer, NULL, ring_producer, ring) != 0) {
+        pk_ring_ii_destroy(ring);
+        return FAIL;
+    }
+
+    // every item arrives once and in the order it was written
+    int result = PASS;
+    int output[29];
+    int expect = 0;
+    size_t n = 1;
+    while (expect < RING_THREAD_ITEMS) {
+        size_t i, num = pk_ring_ii_read(ring, output, n);
+        if (num == 0)
+            sched_yield();
+
+        for (i = 0; i < num; i++) {
+            if (output[i] != expect++)
+                result = FAIL;
+        }
+        n = n % 29 + 1;
+    }
+
+    pthread_join(producer, NULL);
+
+    if (pk_ring_ii_nitems(ring) != 0)
+        result = FAIL;
+
+    pk_ring_ii_destroy(ring);
+
+    if (result == PASS)
+        printf("test_ring_threads passed.\n");
+    return result;
+}
+
 int main(int argc, char *argv[])
 {
     int result = PASS;
@@ -272,9 +506,14 @@ int main(int argc, char *argv[])
     result += test_buffer_sortof_fill();
     result += test_buffer_pop();
     result += test_buffer_read();
+    result += test_buffer_append_view();
     result += test_block_read();
+    result += test_block_append_commit();
     result += test_queue_read();
     result += test_queue_partial_read();
+    result += test_queue_append_wrap();
+    result += test_ring_wrap();
+    result += test_ring_threads();
 
     printf("all buffer tests finished.\n");
     return result;
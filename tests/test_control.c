@@ -0,0 +1,202 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Paul Uri David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "common.h"
+
+#include <math.h>
+#include <complex.h>
+
+// raised cosine pulse with the symbol period normalized to one
+static float raised_cosine(float t, float beta)
+{
+    if (fabsf(t) < 1e-6f)
+        return 1.0f;
+
+    float x = 2.0f * beta * t;
+    float shape = fabsf(fabsf(x) - 1.0f) < 1e-4f ? M_PI / 4.0f : cosf(M_PI * beta * t) / (1.0f - x * x);
+    return sinf(M_PI * t) / (M_PI * t) * shape;
+}
+
+// shape random BPSK symbols at a slightly wrong rate and with
+// a fractional offset, then check the loop locks onto them
+static int run_symsync(float sps, pk_symsync_ted ted)
+{
+    size_t nsym = 2000;
+    size_t nsamps = (size_t) (nsym * sps);
+
+    float *symbols = malloc(nsym * sizeof(float));
+    complex float *samples = malloc(nsamps * sizeof(complex float));
+    complex float *output = malloc(nsamps * sizeof(complex float));
+
+    size_t i, k;
+    for (k = 0; k < nsym; k++)
+        symbols[k] = rand() & 1 ? 1.0f : -1.0f;
+
+    float rate = sps * 1.0005f;
+    float offset = 0.37f;
+    for (i = 0; i < nsamps; i++) {
+        float t = i / rate - offset;
+        float sum = 0;
+
+        long center = lroundf(t);
+        long j;
+        for (j = center - 8; j <= center + 8; j++) {
+            if (j >= 0 && j < (long) nsym)
+                sum += symbols[j] * raised_cosine(t - j, 0.35f);
+        }
+        samples[i] = sum;
+    }
+
+    pk_symsync *ss = pk_symsync_create(sps, ted, 0.02f);
+
+    // feed in small chunks to carry the state between calls
+    size_t nout = 0;
+    for (i = 0; i < nsamps; i += 7) {
+        size_t n = i + 7 < nsamps ? 7 : nsamps - i;
+        nout += pk_symsync_execute(ss, output + nout, samples + i, n);
+    }
+    pk_symsync_destroy(ss);
+
+    int result = nout > nsym - 20 && nout < nsym + 20 ? PASS : FAIL;
+
+    // after settling the symbols are open eyes of the right sign,
+    // allowing for the latency of the interpolator
+    if (result == PASS) {
+        size_t start = nout - 500;
+        int lag, found = 0;
+        for (lag = -3; lag <= 3 && !found; lag++) {
+            found = 1;
+            for (i = start; i < nout - 10; i++) {
+                float y = crealf(output[i]);
+                if (fabsf(y) < 0.6f || (y > 0) != (symbols[i + lag] > 0)) {
+                    found = 0;
+                    break;
+                }
+            }
+        }
+        result = found ? PASS : FAIL;
+    }
+
+    free(output);
+    free(samples);
+    free(symbols);
+    return result;
+}
+
+int test_symsync_gardner()
+{
+    srand(time(NULL));
+
+    if (run_symsync(2.0f, PK_SYMSYNC_GARDNER) != PASS)
+        return FAIL;
+
+    if (run_symsync(4.0f, PK_SYMSYNC_GARDNER) != PASS)
+        return FAIL;
+
+    printf("test_symsync_gardner passed.\n");
+    return PASS;
+}
+
+int test_symsync_mm()
+{
+    srand(time(NULL));
+
+    if (run_symsync(2.0f, PK_SYMSYNC_MM) != PASS)
+        return FAIL;
+
+    if (run_symsync(3.3f, PK_SYMSYNC_MM) != PASS)
+        return FAIL;
+
+    printf("test_symsync_mm passed.\n");
+    return PASS;
+}
+
+// the real path runs the same loop as a complex signal with no
+// imaginary part, so the symbols have to match exactly
+static int run_symsync_real(float sps, pk_symsync_ted ted)
+{
+    size_t nsamps = 4000;
+
+    float *samples = malloc(nsamps * sizeof(float));
+    complex float *wide = malloc(nsamps * sizeof(complex float));
+    float *output = malloc(nsamps * sizeof(float));
+    complex float *expect = malloc(nsamps * sizeof(complex float));
+
+    size_t i;
+    for (i = 0; i < nsamps; i++) {
+        samples[i] = (float) rand() / RAND_MAX * 2.0f - 1.0f;
+        wide[i] = samples[i];
+    }
+
+    pk_symsync *ss = pk_symsync_create(sps, ted, 0.02f);
+    pk_symsync *ref = pk_symsync_create(sps, ted, 0.02f);
+
+    size_t nout = 0, nexpect = 0;
+    for (i = 0; i < nsamps; i += 7) {
+        size_t n = i + 7 < nsamps ? 7 : nsamps - i;
+        nout += pk_symsync_execute_real(ss, output + nout, samples + i, n);
+        nexpect += pk_symsync_execute(ref, expect + nexpect, wide + i, n);
+    }
+    pk_symsync_destroy(ss);
+    pk_symsync_destroy(ref);
+
+    int result = nout == nexpect && nout > 0 ? PASS : FAIL;
+    for (i = 0; i < nout && result == PASS; i++) {
+        if (output[i] != crealf(expect[i]))
+            result = FAIL;
+    }
+
+    free(expect);
+    free(output);
+    free(wide);
+    free(samples);
+    return result;
+}
+
+int test_symsync_real()
+{
+    srand(time(NULL));
+
+    if (run_symsync_real(2.0f, PK_SYMSYNC_GARDNER) != PASS)
+        return FAIL;
+
+    if (run_symsync_real(3.3f, PK_SYMSYNC_MM) != PASS)
+        return FAIL;
+
+    printf("test_symsync_real passed.\n");
+    return PASS;
+}
+
+int main(int argc, char *argv[])
+{
+    int result = PASS;
+
+    // run all of the tests
+    result += test_symsync_gardner();
+    result += test_symsync_mm();
+    result += test_symsync_real();
+
+    printf("all control tests finished.\n");
+    return result;
+}
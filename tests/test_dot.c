@@ -0,0 +1,309 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Paul Uri David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "common.h"
+
+#include <plancki.h>
+
+int test_dotprod_ff()
+{
+    float seq[67];
+    float in[67];
+
+    // small integers keep every partial sum exact
+    srand(time(NULL));
+
+    size_t i, j;
+    for (i = 0; i < 67; i++) {
+        seq[i] = (float) (rand() % 17 - 8);
+        in[i]  = (float) (rand() % 17 - 8);
+    }
+
+    pk_dotprod_ff *dp = pk_dotprod_ff_create(seq, 67);
+
+    int result = PASS;
+
+    // every kernel the cpu runs, over every tail length
+    pk_isa isa;
+    for (isa = PK_ISA_SCALAR; isa <= PK_ISA_NEON; isa++) {
+        if (!pk_dotprod_ff_set_isa(dp, isa))
+            continue;
+
+        for (i = 0; i <= 67; i++) {
+            float expect = 0;
+            for (j = 0; j < i; j++)
+                expect += in[j] * seq[j];
+
+            if (pk_dotprod_ff_execute(dp, in, i) != expect)
+                result = FAIL;
+        }
+    }
+
+    pk_dotprod_ff_destroy(dp);
+
+    if (result == PASS)
+        printf("test_dotprod_ff passed.\n");
+    return result;
+}
+
+int test_dotprod_cc()
+{
+    complex float seq[37];
+    complex float in[37];
+
+    srand(time(NULL));
+
+    size_t i, j;
+    for (i = 0; i < 37; i++) {
+        seq[i] = (rand() % 17 - 8) + I * (rand() % 17 - 8);
+        in[i]  = (rand() % 17 - 8) + I * (rand() % 17 - 8);
+    }
+
+    pk_dotprod_cc *dp = pk_dotprod_cc_create(seq, 37);
+
+    int result = PASS;
+
+    pk_isa isa;
+    for (isa = PK_ISA_SCALAR; isa <= PK_ISA_NEON; isa++) {
+        if (!pk_dotprod_cc_set_isa(dp, isa))
+            continue;
+
+        for (i = 0; i <= 37; i++) {
+            complex float expect = 0;
+            for (j = 0; j < i; j++)
+                expect += in[j] * conjf(seq[j]);
+
+            if (pk_dotprod_cc_execute(dp, in, i) != expect)
+                result = FAIL;
+        }
+    }
+
+    pk_dotprod_cc_destroy(dp);
+
+    if (result == PASS)
+        printf("test_dotprod_cc passed.\n");
+    return result;
+}
+
+int test_dotprod_ii()
+{
+    int seq[45];
+    int in[45];
+
+    srand(time(NULL));
+
+    size_t i, j;
+    for (i = 0; i < 45; i++) {
+        seq[i] = rand() % 2001 - 1000;
+        in[i]  = rand() % 2001 - 1000;
+    }
+
+    pk_dotprod_ii *dp = pk_dotprod_ii_create(seq, 45);
+
+    int result = PASS;
+
+    pk_isa isa;
+    for (isa = PK_ISA_SCALAR; isa <= PK_ISA_NEON; isa++) {
+        if (!pk_dotprod_ii_set_isa(dp, isa))
+            continue;
+
+        for (i = 0; i <= 45; i++) {
+            int expect = 0;
+            for (j = 0; j < i; j++)
+                expect += in[j] * seq[j];
+
+            if (pk_dotprod_ii_execute(dp, in, i) != expect)
+                result = FAIL;
+        }
+    }
+
+    pk_dotprod_ii_destroy(dp);
+
+    if (result == PASS)
+        printf("test_dotprod_ii passed.\n");
+    return result;
+}
+
+int test_dotprod_qq()
+{
+    int16_t seq[75];
+    int16_t in[75];
+
+    srand(time(NULL));
+
+    size_t i, size;
+    for (i = 0; i < 75; i++) {
+        seq[i] = (int16_t) (rand() % 65536 - 32768);
+        in[i]  = (int16_t) (rand() % 65536 - 32768);
+    }
+
+    // every length up to the buffer covers the vector tails
+    for (size = 0; size <= 75; size++) {
+        int64_t acc = 0;
+        for (i = 0; i < size; i++)
+            acc += in[i] * seq[i];
+
+        acc = (acc + (1 << 14)) >> 15;
+        int16_t expect = acc > 32767 ? 32767 : (acc < -32768 ? -32768 : acc);
+
+        pk_dotprod_qq *dp = pk_dotprod_qq_create(seq, size);
+        int16_t result = pk_dotprod_qq_execute(dp, in, size);
+        pk_dotprod_qq_destroy(dp);
+
+        if (result != expect)
+            return FAIL;
+    }
+
+    // large sums saturate instead of wrapping
+    for (i = 0; i < 75; i++) {
+        seq[i] = 32767;
+        in[i] = 32767;
+    }
+
+    pk_dotprod_qq *dp = pk_dotprod_qq_create(seq, 75);
+    int16_t high = pk_dotprod_qq_execute(dp, in, 75);
+    pk_dotprod_qq_destroy(dp);
+
+    if (high != 32767)
+        return FAIL;
+
+    printf("test_dotprod_qq passed.\n");
+    return PASS;
+}
+
+int test_dotprod_qq_kernels()
+{
+    int16_t seq[75];
+    int16_t in[75];
+
+    int result = PASS;
+
+    pk_isa isa;
+    for (isa = PK_ISA_SCALAR; isa <= PK_ISA_NEON; isa++) {
+        if (isa != PK_ISA_SCALAR && pk_dotprod_qq_isa(isa) == NULL)
+            continue;
+
+        // -1 * -1 is a valid Q15 product and has to saturate high
+        size_t i, size;
+        for (i = 0; i < 75; i++) {
+            seq[i] = -32768;
+            in[i] = -32768;
+        }
+
+        pk_dotprod_qq *dp = pk_dotprod_qq_create(seq, 75);
+        pk_dotprod_qq_set_isa(dp, isa);
+
+        for (size = 2; size <= 75; size++) {
+            if (pk_dotprod_qq_execute(dp, in, size) != 32767)
+                result = FAIL;
+        }
+
+        // full scale values mixed with random ones
+        for (i = 0; i < 75; i++) {
+            seq[i] = rand() % 3 ? -32768 : (int16_t) (rand() % 65536 - 32768);
+            in[i] = rand() % 3 ? -32768 : (int16_t) (rand() % 65536 - 32768);
+        }
+        pk_dotprod_qq_load(dp, seq, 75);
+
+        for (size = 0; size <= 75; size++) {
+            int64_t acc = 0;
+            for (i = 0; i < size; i++)
+                acc += in[i] * seq[i];
+
+            acc = (acc + (1 << 14)) >> 15;
+            int16_t expect = acc > 32767 ? 32767 : (acc < -32768 ? -32768 : acc);
+
+            if (pk_dotprod_qq_execute(dp, in, size) != expect)
+                result = FAIL;
+        }
+
+        pk_dotprod_qq_destroy(dp);
+    }
+
+    if (result == PASS)
+        printf("test_dotprod_qq_kernels passed.\n");
+    return result;
+}
+
+int test_dotprod_scalar_baseline()
+{
+    float seq_f[300], in_f[300];
+    complex float seq_c[300], in_c[300];
+
+    srand(time(NULL));
+
+    size_t i;
+    for (i = 0; i < 300; i++) {
+        seq_f[i] = (rand() % 20001 - 10000) / 7919.0f;
+        in_f[i] = (rand() % 20001 - 10000) / 7919.0f;
+        seq_c[i] = (rand() % 20001 - 10000) / 7919.0f + I * (rand() % 20001 - 10000) / 7919.0f;
+        in_c[i] = (rand() % 20001 - 10000) / 7919.0f + I * (rand() % 20001 - 10000) / 7919.0f;
+    }
+
+    pk_dotprod_ff *dp_f = pk_dotprod_ff_create(seq_f, 300);
+    pk_dotprod_cc *dp_c = pk_dotprod_cc_create(seq_c, 300);
+    pk_dotprod_ff_set_isa(dp_f, PK_ISA_SCALAR);
+    pk_dotprod_cc_set_isa(dp_c, PK_ISA_SCALAR);
+
+    int result = PASS;
+
+    // the scalar fallback has to match the original loop bit for bit
+    size_t size;
+    for (size = 0; size <= 300; size++) {
+        float expect_f = 0;
+        complex float expect_c = 0;
+        for (i = 0; i < size; i++) {
+            expect_f += (in_f[i] * conj(seq_f[i]));
+            expect_c += (in_c[i] * conj(seq_c[i]));
+        }
+
+        if (pk_dotprod_ff_execute(dp_f, in_f, size) != expect_f)
+            result = FAIL;
+        if (pk_dotprod_cc_execute(dp_c, in_c, size) != expect_c)
+            result = FAIL;
+    }
+
+    pk_dotprod_ff_destroy(dp_f);
+    pk_dotprod_cc_destroy(dp_c);
+
+    if (result == PASS)
+        printf("test_dotprod_scalar_baseline passed.\n");
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    int result = PASS;
+
+    // run all of the tests
+    result += test_dotprod_ff();
+    result += test_dotprod_cc();
+    result += test_dotprod_ii();
+    result += test_dotprod_qq();
+    result += test_dotprod_qq_kernels();
+    result += test_dotprod_scalar_baseline();
+
+    printf("all dot product tests finished.\n");
+    return result;
+}
@@ -0,0 +1,418 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Paul Uri David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "common.h"
+
+#include <plancki.h>
+
+#include <string.h>
+#include <math.h>
+
+// the original bit at a time AX.25 CRC
+static unsigned int crc_ax25_bitwise(const unsigned char *data, size_t size)
+{
+    unsigned int crc = 0xffff;
+
+    size_t i, j;
+    for (i = 0; i < size; i++) {
+        for (j = 0; j < 8; j++) {
+            unsigned int bit = (data[i] >> j) & 1;
+            crc = (crc >> 1) ^ (0x8408 & -((crc & 1) ^ bit));
+        }
+    }
+
+    return crc;
+}
+
+int test_crc_check()
+{
+    const unsigned char *check = (const unsigned char *) "123456789";
+
+    struct {
+        unsigned int width;
+        uint32_t poly;
+        int reflect;
+        uint32_t init;
+        uint32_t xorout;
+        uint32_t expect;
+    } params[] = {
+        { 8, 0x07, 0, 0x00, 0x00, 0xf4 },
+        { 8, 0x31, 1, 0x00, 0x00, 0xa1 },
+        { 24, 0x864cfb, 0, 0xb704ce, 0x000000, 0x21cf02 },
+        { 32, 0x04c11db7, 0, 0xffffffff, 0xffffffff, 0xfc891918 },
+    };
+
+    int result = PASS;
+
+    pk_crc *ax25 = pk_crc_create_preset(PK_CRC_AX25);
+    pk_crc *ccitt = pk_crc_create_preset(PK_CRC_16_CCITT);
+    pk_crc *crc32 = pk_crc_create_preset(PK_CRC_32);
+
+    if (pk_crc_compute(ax25, check, 9) != 0x906e)
+        result = FAIL;
+    if (pk_crc_compute(ccitt, check, 9) != 0x29b1)
+        result = FAIL;
+    if (pk_crc_compute(crc32, check, 9) != 0xcbf43926)
+        result = FAIL;
+
+    pk_crc_destroy(ax25);
+    pk_crc_destroy(ccitt);
+    pk_crc_destroy(crc32);
+
+    size_t i;
+    for (i = 0; i < sizeof(params) / sizeof(params[0]); i++) {
+        pk_crc *c = pk_crc_create(params[i].width, params[i].poly, params[i].reflect,
+                                  params[i].init, params[i].xorout);
+        if (pk_crc_compute(c, check, 9) != params[i].expect)
+            result = FAIL;
+        pk_crc_destroy(c);
+    }
+
+    if (result == PASS)
+        printf("test_crc_check passed.\n");
+    return result;
+}
+
+int test_crc_ax25_exact()
+{
+    srand(time(NULL));
+
+    unsigned char data[600];
+    size_t i;
+    for (i = 0; i < sizeof(data); i++)
+        data[i] = rand() & 0xff;
+
+    pk_crc *c = pk_crc_create_preset(PK_CRC_AX25);
+
+    int result = PASS;
+
+    // lengths on both sides of the folding threshold and the slices
+    size_t size;
+    for (size = 0; size <= sizeof(data); size++) {
+        unsigned int expect = crc_ax25_bitwise(data, size);
+
+        if (crc_ax25_byte(data, size) != expect)
+            result = FAIL;
+        if (pk_crc_update(c, pk_crc_init(c), data, size) != expect)
+            result = FAIL;
+        if (pk_crc_compute(c, data, size) != (expect ^ 0xffff))
+            result = FAIL;
+    }
+
+    pk_crc_destroy(c);
+
+    if (result == PASS)
+        printf("test_crc_ax25_exact passed.\n");
+    return result;
+}
+
+int test_crc_streaming()
+{
+    unsigned char data[1000];
+    size_t i;
+    for (i = 0; i < sizeof(data); i++)
+        data[i] = rand() & 0xff;
+
+    pk_crc *crcs[] = {
+        pk_crc_create_preset(PK_CRC_32),
+        pk_crc_create_preset(PK_CRC_16_CCITT),
+        pk_crc_create(12, 0x80f, 1, 0x000, 0x000),
+    };
+
+    int result = PASS;
+
+    size_t n;
+    for (n = 0; n < sizeof(crcs) / sizeof(crcs[0]); n++) {
+        pk_crc *c = crcs[n];
+
+        // a byte at a time never takes the wide paths
+        uint32_t reg = pk_crc_init(c);
+        for (i = 0; i < sizeof(data); i++)
+            reg = pk_crc_update(c, reg, data + i, 1);
+        uint32_t expect = pk_crc_final(c, reg);
+
+        if (pk_crc_compute(c, data, sizeof(data)) != expect)
+            result = FAIL;
+
+        // uneven chunks
+        reg = pk_crc_init(c);
+        size_t pos = 0, chunk = 1;
+        while (pos < sizeof(data)) {
+            size_t take = chunk < sizeof(data) - pos ? chunk : sizeof(data) - pos;
+            reg = pk_crc_update(c, reg, data + pos, take);
+            pos += take;
+            chunk = chunk * 3 + 1;
+        }
+
+        if (pk_crc_final(c, reg) != expect)
+            result = FAIL;
+
+        pk_crc_destroy(c);
+    }
+
+    if (result == PASS)
+        printf("test_crc_streaming passed.\n");
+    return result;
+}
+
+// decode the whole of soft in uneven chunks and compare with bits,
+// the stream has to end with the six zero tail bits
+static int viterbi_decode_matches(const unsigned char *soft, const unsigned char *bits, size_t num)
+{
+    pk_viterbi *v = pk_viterbi_create();
+
+    size_t decoded = 0;
+    int result = PASS;
+
+    size_t i, j, nitems;
+    for (i = 0; i < 2 * num; i += 333) {
+        pk_viterbi_process(v, soft + i, 2 * num - i < 333 ? 2 * num - i : 333);
+        unsigned char *out = pk_viterbi_read(v, &nitems);
+
+        for (j = 0; j < nitems; j++, decoded++) {
+            if (decoded >= num || out[j] != bits[decoded])
+                result = FAIL;
+        }
+    }
+
+    pk_viterbi_terminate(v);
+    unsigned char *out = pk_viterbi_read(v, &nitems);
+    for (j = 0; j < nitems; j++, decoded++) {
+        if (decoded >= num || out[j] != bits[decoded])
+            result = FAIL;
+    }
+
+    if (decoded != num)
+        result = FAIL;
+
+    pk_viterbi_destroy(v);
+    return result;
+}
+
+int test_viterbi_clean()
+{
+    unsigned char bits[2000];
+    unsigned char soft[4000];
+
+    size_t i, nitems;
+    for (i = 0; i < 2000; i++)
+        bits[i] = i < 1994 ? rand() & 1 : 0;
+
+    pk_convenc *enc = pk_convenc_create();
+    pk_convenc_process(enc, bits, 2000);
+    unsigned char *symbols = pk_convenc_read(enc, &nitems);
+
+    // the first generator on the all ones register gives 1, the
+    // inverted second one gives 0
+    unsigned char ones[7] = {1, 1, 1, 1, 1, 1, 1};
+    pk_convenc *check = pk_convenc_create();
+    pk_convenc_process(check, ones, 7);
+    unsigned char *check_symbols = pk_convenc_read(check, &nitems);
+
+    int result = PASS;
+    if (check_symbols[12] != 1 || check_symbols[13] != 0)
+        result = FAIL;
+
+    // hard decisions with a few isolated symbol errors
+    for (i = 0; i < 4000; i++)
+        soft[i] = symbols[i] ? 255 : 0;
+    for (i = 50; i < 4000; i += 97)
+        soft[i] ^= 0xff;
+
+    if (viterbi_decode_matches(soft, bits, 2000) != PASS)
+        result = FAIL;
+
+    pk_convenc_destroy(enc);
+    pk_convenc_destroy(check);
+
+    if (result == PASS)
+        printf("test_viterbi_clean passed.\n");
+    return result;
+}
+
+int test_viterbi_noisy()
+{
+    size_t num = 20000;
+    unsigned char *bits = malloc(num);
+    unsigned char *soft = malloc(2 * num);
+
+    // a fixed seed keeps the noise, and so the result, reproducible
+    srand(1);
+
+    // six zero bits bring the encoder back to the all zero state
+    size_t i, nitems;
+    for (i = 0; i < num; i++)
+        bits[i] = i < num - 6 ? rand() & 1 : 0;
+
+    pk_convenc *enc = pk_convenc_create();
+    pk_convenc_process(enc, bits, num);
+    unsigned char *symbols = pk_convenc_read(enc, &nitems);
+
+    // Eb/N0 of 6 dB, the code gives a bit error rate around 1e-7
+    float sigma = sqrtf(1.0f / (2.0f * 0.5f * powf(10.0f, 0.6f)));
+    for (i = 0; i < 2 * num; i++) {
+        float u1 = (rand() + 1.0f) / (RAND_MAX + 2.0f);
+        float u2 = (rand() + 1.0f) / (RAND_MAX + 2.0f);
+        float noise = sigma * sqrtf(-2.0f * logf(u1)) * cosf(2.0f * M_PI * u2);
+
+        float x = (symbols[i] ? 1.0f : -1.0f) + noise;
+        float q = 127.5f + 64.0f * x;
+        soft[i] = q < 0.0f ? 0 : (q > 255.0f ? 255 : (unsigned char) q);
+    }
+
+    int result = viterbi_decode_matches(soft, bits, num);
+
+    pk_convenc_destroy(enc);
+    free(bits);
+    free(soft);
+
+    if (result == PASS)
+        printf("test_viterbi_noisy passed.\n");
+    return result;
+}
+
+int test_viterbi_restart()
+{
+    unsigned char bits[2][500];
+    unsigned char soft[2][1001];
+
+    size_t i, k, nitems;
+    for (k = 0; k < 2; k++) {
+        for (i = 0; i < 500; i++)
+            bits[k][i] = i < 494 ? rand() & 1 : 0;
+
+        pk_convenc *enc = pk_convenc_create();
+        pk_convenc_process(enc, bits[k], 500);
+        unsigned char *symbols = pk_convenc_read(enc, &nitems);
+        for (i = 0; i < 1000; i++)
+            soft[k][i] = symbols[i] ? 255 : 0;
+        pk_convenc_destroy(enc);
+    }
+
+    // the first stream ends on a stray symbol
+    soft[0][1000] = 255;
+
+    pk_viterbi *v = pk_viterbi_create();
+
+    int result = PASS;
+    for (k = 0; k < 2; k++) {
+        pk_viterbi_process(v, soft[k], k == 0 ? 1001 : 1000);
+        unsigned char *out = pk_viterbi_read(v, &nitems);
+        size_t decoded = nitems;
+        if (memcmp(out, bits[k], nitems) != 0)
+            result = FAIL;
+
+        // the second stream decodes as if the decoder were new
+        pk_viterbi_terminate(v);
+        out = pk_viterbi_read(v, &nitems);
+        if (decoded + nitems != 500 || memcmp(out, bits[k] + decoded, nitems) != 0)
+            result = FAIL;
+    }
+
+    pk_viterbi_destroy(v);
+
+    if (result == PASS)
+        printf("test_viterbi_restart passed.\n");
+    return result;
+}
+
+int test_viterbi_kernels()
+{
+    // random symbols keep the metrics spread and the decisions close
+    size_t num = 5000;
+    unsigned char *soft = malloc(2 * num);
+
+    size_t i;
+    for (i = 0; i < 2 * num; i++)
+        soft[i] = rand() & 0xff;
+
+    unsigned char *expect = malloc(num);
+    unsigned char *out;
+    size_t nitems, n;
+
+    int result = PASS;
+
+    pk_isa isa;
+    for (isa = PK_ISA_SCALAR; isa <= PK_ISA_NEON; isa++) {
+        pk_viterbi *v = pk_viterbi_create();
+        if (!pk_viterbi_set_isa(v, isa)) {
+            pk_viterbi_destroy(v);
+            continue;
+        }
+
+        n = 0;
+        for (i = 0; i < 2 * num; i += 777) {
+            pk_viterbi_process(v, soft + i, 2 * num - i < 777 ? 2 * num - i : 777);
+            out = pk_viterbi_read(v, &nitems);
+
+            size_t j;
+            for (j = 0; j < nitems && n < num; j++, n++) {
+                if (isa == PK_ISA_SCALAR)
+                    expect[n] = out[j];
+                else if (expect[n] != out[j])
+                    result = FAIL;
+            }
+        }
+
+        pk_viterbi_flush(v);
+        out = pk_viterbi_read(v, &nitems);
+
+        size_t j;
+        for (j = 0; j < nitems && n < num; j++, n++) {
+            if (isa == PK_ISA_SCALAR)
+                expect[n] = out[j];
+            else if (expect[n] != out[j])
+                result = FAIL;
+        }
+
+        if (n != num)
+            result = FAIL;
+
+        pk_viterbi_destroy(v);
+    }
+
+    free(soft);
+    free(expect);
+
+    if (result == PASS)
+        printf("test_viterbi_kernels passed.\n");
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    int result = PASS;
+
+    // run all of the tests
+    result += test_crc_check();
+    result += test_crc_ax25_exact();
+    result += test_crc_streaming();
+    result += test_viterbi_clean();
+    result += test_viterbi_noisy();
+    result += test_viterbi_restart();
+    result += test_viterbi_kernels();
+
+    printf("all fec tests finished.\n");
+    return result;
+}
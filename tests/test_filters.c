@@ -24,6 +24,8 @@
 
 #include "common.h"
 
+#include <math.h>
+
 int test_fir_impulse()
 {
     unsigned int order = 3;
@@ -46,6 +48,279 @@ int test_fir_impulse()
     return PASS;
 }
 
+int test_fir_cc_history()
+{
+    unsigned int order = 12;
+    complex float coeff[13];
+    complex float samples[100];
+    complex float expect[100];
+    complex float output[100];
+
+    srand(time(NULL));
+
+    size_t i, j;
+    for (i = 0; i <= order; i++)
+        coeff[i] = (rand() % 9 - 4) + I * (rand() % 9 - 4);
+
+    for (i = 0; i < 100; i++)
+        samples[i] = (rand() % 9 - 4) + I * (rand() % 9 - 4);
+
+    // direct convolution as the reference
+    for (i = 0; i < 100; i++) {
+        expect[i] = 0;
+        for (j = 0; j <= order && j <= i; j++)
+            expect[i] += coeff[j] * samples[i - j];
+    }
+
+    // split the input so the history wraps between calls
+    pk_fir_cc *filter = pk_fir_cc_create(order, coeff);
+    pk_fir_cc_execute(filter, output, samples, 7);
+    pk_fir_cc_execute(filter, output + 7, samples + 7, 60);
+    pk_fir_cc_execute(filter, output + 67, samples + 67, 33);
+    pk_fir_cc_destroy(filter);
+
+    for (i = 0; i < 100; i++) {
+        if (output[i] != expect[i])
+            return FAIL;
+    }
+
+    printf("test_fir_cc_history passed.\n");
+    return PASS;
+}
+
+int test_fir_ff_block()
+{
+    unsigned int order = 63;
+    float coeff[64];
+    float samples[5000];
+    float output[5000];
+
+    srand(time(NULL));
+
+    size_t i, j;
+    for (i = 0; i <= order; i++)
+        coeff[i] = (float) (rand() % 9 - 4);
+
+    for (i = 0; i < 5000; i++)
+        samples[i] = (float) (rand() % 9 - 4);
+
+    // spans several staged blocks plus a short call
+    pk_fir_ff *filter = pk_fir_ff_create(order, coeff);
+    pk_fir_ff_execute(filter, output, samples, 4995);
+    pk_fir_ff_execute(filter, output + 4995, samples + 4995, 5);
+    pk_fir_ff_destroy(filter);
+
+    for (i = 0; i < 5000; i++) {
+        float expect = 0;
+        for (j = 0; j <= order && j <= i; j++)
+            expect += coeff[j] * samples[i - j];
+
+        if (output[i] != expect)
+            return FAIL;
+    }
+
+    printf("test_fir_ff_block passed.\n");
+    return PASS;
+}
+
+int test_fftfilt_cc_match()
+{
+    unsigned int order = 599;
+    complex float coeff[600];
+    complex float samples[6000];
+    complex float expect[6000];
+    complex float output[6000];
+
+    srand(time(NULL));
+
+    size_t i;
+    for (i = 0; i <= order; i++)
+        coeff[i] = (rand() % 2001 - 1000) / 1000.0f + I * (rand() % 2001 - 1000) / 1000.0f;
+
+    for (i = 0; i < 6000; i++)
+        samples[i] = (rand() % 2001 - 1000) / 1000.0f + I * (rand() % 2001 - 1000) / 1000.0f;
+
+    pk_fir_cc *fir = pk_fir_cc_create(order, coeff);
+    pk_fir_cc_execute(fir, expect, samples, 6000);
+    pk_fir_cc_destroy(fir);
+
+    // arbitrary block sizes, including ones larger than a transform
+    pk_fftfilt_cc *filter = pk_fftfilt_cc_create(order, 0, coeff);
+    pk_fftfilt_cc_execute(filter, output, samples, 1);
+    pk_fftfilt_cc_execute(filter, output + 1, samples + 1, 130);
+    pk_fftfilt_cc_execute(filter, output + 131, samples + 131, 5869);
+    size_t delay = pk_fftfilt_cc_delay(filter);
+    pk_fftfilt_cc_destroy(filter);
+
+    for (i = 0; i < delay; i++) {
+        if (output[i] != 0)
+            return FAIL;
+    }
+
+    for (i = delay; i < 6000; i++) {
+        if (cabsf(output[i] - expect[i - delay]) > 0.001f * (1.0f + cabsf(expect[i - delay])))
+            return FAIL;
+    }
+
+    printf("test_fftfilt_cc_match passed.\n");
+    return PASS;
+}
+
+int test_fftfilt_ff_match()
+{
+    unsigned int order = 150;
+    float coeff[151];
+    float samples[4000];
+    float expect[4000];
+    float output[4000];
+
+    srand(time(NULL));
+
+    size_t i;
+    for (i = 0; i <= order; i++)
+        coeff[i] = (rand() % 2001 - 1000) / 1000.0f;
+
+    for (i = 0; i < 4000; i++)
+        samples[i] = (rand() % 2001 - 1000) / 1000.0f;
+
+    pk_fir_ff *fir = pk_fir_ff_create(order, coeff);
+    pk_fir_ff_execute(fir, expect, samples, 4000);
+    pk_fir_ff_destroy(fir);
+
+    // the default transform and a short one that is not a power of two
+    unsigned int sizes[2] = {0, 320};
+
+    int k;
+    for (k = 0; k < 2; k++) {
+        // single samples and random sizes, filtered in place
+        pk_fftfilt_ff *filter = pk_fftfilt_ff_create(order, sizes[k], coeff);
+        memcpy(output, samples, sizeof(samples));
+        size_t offset = 0;
+        while (offset < 4000) {
+            size_t size = (offset < 50) ? 1 : (size_t) (rand() % 700);
+            if (size > 4000 - offset)
+                size = 4000 - offset;
+            pk_fftfilt_ff_execute(filter, output + offset, output + offset, size);
+            offset += size;
+        }
+        size_t delay = pk_fftfilt_ff_delay(filter);
+        pk_fftfilt_ff_destroy(filter);
+
+        if (k == 1 && delay != 320 - order)
+            return FAIL;
+
+        for (i = 0; i < delay; i++) {
+            if (output[i] != 0)
+                return FAIL;
+        }
+
+        for (i = delay; i < 4000; i++) {
+            if (fabsf(output[i] - expect[i - delay]) > 0.001f * (1.0f + fabsf(expect[i - delay])))
+                return FAIL;
+        }
+    }
+
+    printf("test_fftfilt_ff_match passed.\n");
+    return PASS;
+}
+
+int test_firdecim_interp()
+{
+    unsigned int order = 22;
+    unsigned int factor = 5;
+    float coeff[23];
+    float samples[200];
+    float stuffed[1000];
+    float expect[1000];
+    float output[1000];
+
+    srand(time(NULL));
+
+    size_t i;
+    for (i = 0; i <= order; i++)
+        coeff[i] = (float) (rand() % 9 - 4);
+
+    for (i = 0; i < 200; i++)
+        samples[i] = (float) (rand() % 9 - 4);
+
+    // the decimator keeps the last output of every factor samples
+    pk_fir_ff *fir = pk_fir_ff_create(order, coeff);
+    pk_fir_ff_execute(fir, expect, samples, 200);
+    pk_fir_ff_destroy(fir);
+
+    pk_firdecim_ff *decim = pk_firdecim_ff_create(factor, order, coeff);
+    size_t nitems = pk_firdecim_ff_execute(decim, output, samples, 13);
+    nitems += pk_firdecim_ff_execute(decim, output + nitems, samples + 13, 187);
+    pk_firdecim_ff_destroy(decim);
+
+    if (nitems != 200 / factor)
+        return FAIL;
+
+    for (i = 0; i < nitems; i++) {
+        if (output[i] != expect[factor * i + factor - 1])
+            return FAIL;
+    }
+
+    // the interpolator matches filtering the zero-stuffed input
+    for (i = 0; i < 1000; i++)
+        stuffed[i] = i % factor == 0 ? samples[i / factor] : 0;
+
+    fir = pk_fir_ff_create(order, coeff);
+    pk_fir_ff_execute(fir, expect, stuffed, 1000);
+    pk_fir_ff_destroy(fir);
+
+    pk_firinterp_ff *interp = pk_firinterp_ff_create(factor, order, coeff);
+    pk_firinterp_ff_execute(interp, output, samples, 3);
+    pk_firinterp_ff_execute(interp, output + 3 * factor, samples + 3, 197);
+    pk_firinterp_ff_destroy(interp);
+
+    for (i = 0; i < 1000; i++) {
+        if (output[i] != expect[i])
+            return FAIL;
+    }
+
+    printf("test_firdecim_interp passed.\n");
+    return PASS;
+}
+
+int test_fir_qq()
+{
+    unsigned int order = 40;
+    int16_t coeff[41];
+    int16_t samples[3000];
+    int16_t output[3000];
+
+    srand(time(NULL));
+
+    size_t i, j;
+    for (i = 0; i <= order; i++)
+        coeff[i] = (int16_t) (rand() % 8001 - 4000);
+
+    for (i = 0; i < 3000; i++)
+        samples[i] = (int16_t) (rand() % 65536 - 32768);
+
+    pk_fir_qq *filter = pk_fir_qq_create(order, coeff);
+    pk_fir_qq_execute(filter, output, samples, 2997);
+    pk_fir_qq_execute(filter, output + 2997, samples + 2997, 3);
+    pk_fir_qq_destroy(filter);
+
+    // Q30 sums rounded and saturated back to Q15
+    for (i = 0; i < 3000; i++) {
+        int64_t acc = 0;
+        for (j = 0; j <= order && j <= i; j++)
+            acc += coeff[j] * samples[i - j];
+
+        acc = (acc + (1 << 14)) >> 15;
+        int16_t expect = acc > 32767 ? 32767 : (acc < -32768 ? -32768 : acc);
+
+        if (output[i] != expect)
+            return FAIL;
+    }
+
+    printf("test_fir_qq passed.\n");
+    return PASS;
+}
+
 int test_iirso_impulse()
 {
     float a[3] = {1, 1, 0.5};
@@ -107,6 +382,12 @@ int main(int argc, char *argv[])
 
     // run all of the tests
     result += test_fir_impulse();
+    result += test_fir_cc_history();
+    result += test_fir_ff_block();
+    result += test_fftfilt_cc_match();
+    result += test_fftfilt_ff_match();
+    result += test_firdecim_interp();
+    result += test_fir_qq();
     result += test_iirso_impulse();
     result += test_iir_cascade_impulse();
 
@@ -109,6 +109,306 @@ int test_ax25_framer_extra_bits()
     return PASS;
 }
 
+typedef struct
+{
+    unsigned char payloads[4][64];
+    size_t sizes[4];
+    size_t num;
+    size_t valid;
+    int result;
+} frame_log;
+
+static void log_callback(
+    int valid,
+    unsigned char *payload,
+    void *info,
+    size_t size)
+{
+    frame_log *log = info;
+
+    // noise between flags passes the CRC once in a while,
+    // only frames as long as a test payload are counted
+    if (!valid || size < 20 + 2)
+        return;
+
+    // payloads come back with the two FCS bytes
+    if (log->valid >= log->num || size != log->sizes[log->valid] + 2
+        || memcmp(payload, log->payloads[log->valid], size - 2) != 0)
+        log->result = FAIL;
+
+    log->valid++;
+}
+
+int test_ax25_deframer_packed()
+{
+    srand(time(NULL));
+
+    frame_log log;
+    log.num = 4;
+    log.result = PASS;
+
+    // noise, frames and frames back to back sharing their flags
+    unsigned char stream[4 * 8 * 80 + 3000];
+    size_t nbits = 0;
+
+    pk_ax25_framer *framer = pk_ax25_framer_create(0);
+
+    size_t i, n;
+    for (n = 0; n < log.num; n++) {
+        if (n != 2) {
+            size_t noise = 200 + rand() % 300;
+            for (i = 0; i < noise; i++)
+                stream[nbits++] = rand() & 1;
+        }
+
+        log.sizes[n] = 20 + rand() % 44;
+        for (i = 0; i < log.sizes[n]; i++)
+            log.payloads[n][i] = rand() & 0xff;
+
+        size_t frame_size;
+        pk_ax25_framer_process(framer, log.payloads[n], log.sizes[n]);
+        unsigned char *frame_data = pk_ax25_framer_read(framer, &frame_size);
+        memcpy(stream + nbits, frame_data, frame_size);
+        nbits += frame_size;
+    }
+
+    for (i = 0; i < 13; i++)
+        stream[nbits++] = 0;
+
+    unsigned char packed[sizeof(stream) / 8];
+    for (i = 0; i < nbits / 8; i++)
+        packed[i] = pk_pack_byte_rl(stream + 8 * i);
+
+    // unpacked bits in uneven chunks
+    log.valid = 0;
+    pk_ax25_deframer *deframer = pk_ax25_deframer_create(&log, log_callback);
+    for (i = 0; i < nbits; i += 37)
+        pk_ax25_deframer_process(deframer, stream + i, nbits - i < 37 ? nbits - i : 37);
+    pk_ax25_deframer_destroy(deframer);
+
+    if (log.valid != log.num)
+        log.result = FAIL;
+
+    // packed bytes in uneven chunks
+    log.valid = 0;
+    deframer = pk_ax25_deframer_create(&log, log_callback);
+    for (i = 0; i < nbits / 8; i += 5)
+        pk_ax25_deframer_process_packed(deframer, packed + i, nbits / 8 - i < 5 ? nbits / 8 - i : 5);
+    pk_ax25_deframer_destroy(deframer);
+
+    if (log.valid != log.num)
+        log.result = FAIL;
+
+    pk_ax25_framer_destroy(framer);
+
+    if (log.result == PASS)
+        printf("test_ax25_deframer_packed passed.\n");
+    return log.result;
+}
+
+// bit at a time reference for the packed framer, stuffing
+// restarts after every opening flag
+static size_t reference_framer(
+    unsigned char *out,
+    const unsigned char *bytes,
+    size_t size,
+    unsigned int padding)
+{
+    static const unsigned char flag[8] = {0, 1, 1, 1, 1, 1, 1, 0};
+
+    unsigned int crc = crc_ax25_byte(bytes, size) ^ 0xffff;
+    unsigned char crc_bytes[2] = {crc & 0xff, crc >> 8};
+
+    size_t n = 0;
+    size_t i, j;
+    for (i = 0; i < padding; i++)
+        out[n++] = 0;
+    for (i = 0; i < 8; i++)
+        out[n++] = flag[i];
+
+    unsigned int count = 0;
+    for (i = 0; i < size + 2; i++) {
+        unsigned char byte = i < size ? bytes[i] : crc_bytes[i - size];
+        for (j = 0; j < 8; j++) {
+            out[n++] = (byte >> j) & 1;
+            count = (byte >> j) & 1 ? count + 1 : 0;
+            if (count == 5) {
+                out[n++] = 0;
+                count = 0;
+            }
+        }
+    }
+
+    for (i = 0; i < 8; i++)
+        out[n++] = flag[i];
+    for (i = 0; i < padding; i++)
+        out[n++] = 0;
+
+    return n;
+}
+
+int test_ax25_framer_packed()
+{
+    unsigned char data[300];
+    unsigned char expect[8 * 400 + 200];
+
+    pk_ax25_framer *framer = pk_ax25_framer_create(37);
+    pk_ax25_framer *nrzi = pk_ax25_framer_create(37);
+    pk_ax25_framer_set_nrzi(nrzi, 1);
+
+    int result = PASS;
+    unsigned int level = 0;
+
+    size_t n;
+    for (n = 0; n < 20; n++) {
+        size_t size = 1 + rand() % 300;
+
+        // runs of ones exercise the stuffing
+        size_t i;
+        for (i = 0; i < size; i++)
+            data[i] = n % 2 ? rand() & 0xff : (rand() % 4 ? 0xff : rand() & 0xff);
+
+        size_t expect_size = reference_framer(expect, data, size, 37);
+
+        size_t frame_size;
+        pk_ax25_framer_process(framer, data, size);
+        unsigned char *frame = pk_ax25_framer_read(framer, &frame_size);
+
+        if (frame_size != expect_size || memcmp(frame, expect, expect_size) != 0)
+            result = FAIL;
+
+        size_t nbits;
+        pk_ax25_framer_process_packed(framer, data, size);
+        unsigned char *packed = pk_ax25_framer_read_packed(framer, &nbits);
+
+        if (nbits != expect_size)
+            result = FAIL;
+        for (i = 0; i < nbits && i < expect_size; i++) {
+            if (((packed[i / 8] >> (i % 8)) & 1) != expect[i])
+                result = FAIL;
+        }
+
+        // the line holds on a one and toggles on a zero
+        pk_ax25_framer_process_packed(nrzi, data, size);
+        packed = pk_ax25_framer_read_packed(nrzi, &nbits);
+
+        for (i = 0; i < nbits && i < expect_size; i++) {
+            level ^= !expect[i];
+            if (((packed[i / 8] >> (i % 8)) & 1) != level)
+                result = FAIL;
+        }
+    }
+
+    pk_ax25_framer_destroy(framer);
+    pk_ax25_framer_destroy(nrzi);
+
+    if (result == PASS)
+        printf("test_ax25_framer_packed passed.\n");
+    return result;
+}
+
+int test_ax25_framer_restart()
+{
+    unsigned char expect[8 * 8];
+    unsigned char data[2] = {0xff, 0};
+
+    pk_ax25_framer *framer = pk_ax25_framer_create(0);
+
+    int result = PASS;
+
+    // some of these frames end on a run of ones, the next frame opens
+    // with eight more and must be stuffed as if it stood alone
+    unsigned int k;
+    for (k = 0; k < 256; k++) {
+        data[1] = k;
+        size_t expect_size = reference_framer(expect, data, 2, 0);
+
+        int rep;
+        for (rep = 0; rep < 2; rep++) {
+            size_t frame_size;
+            pk_ax25_framer_process(framer, data, 2);
+            unsigned char *frame = pk_ax25_framer_read(framer, &frame_size);
+
+            if (frame_size != expect_size || memcmp(frame, expect, expect_size) != 0)
+                result = FAIL;
+        }
+    }
+
+    pk_ax25_framer_destroy(framer);
+
+    if (result == PASS)
+        printf("test_ax25_framer_restart passed.\n");
+    return result;
+}
+
+int test_g3ruh_deframer()
+{
+    frame_log log;
+    log.num = 3;
+    log.result = PASS;
+
+    unsigned char stream[3 * 8 * 90 + 1000];
+    size_t nbits = 0;
+
+    pk_ax25_framer *framer = pk_ax25_framer_create(16);
+    pk_ax25_framer_set_nrzi(framer, 1);
+
+    size_t i, n;
+    for (i = 0; i < 300; i++)
+        stream[nbits++] = rand() & 1;
+
+    for (n = 0; n < log.num; n++) {
+        log.sizes[n] = 20 + rand() % 44;
+        for (i = 0; i < log.sizes[n]; i++)
+            log.payloads[n][i] = rand() & 0xff;
+
+        size_t frame_bits;
+        pk_ax25_framer_process_packed(framer, log.payloads[n], log.sizes[n]);
+        unsigned char *packed = pk_ax25_framer_read_packed(framer, &frame_bits);
+
+        for (i = 0; i < frame_bits; i++)
+            stream[nbits++] = (packed[i / 8] >> (i % 8)) & 1;
+    }
+
+    // scramble the NRZI line, then flip the polarity which
+    // the receive chain doesn't care about
+    pk_mult_scrambler *scrambler = pk_mult_scrambler_create(17, 0);
+    for (i = 0; i < nbits; i++)
+        stream[i] = !pk_mult_scrambler_execute(scrambler, stream[i]);
+    pk_mult_scrambler_destroy(scrambler);
+
+    for (; nbits % 8; nbits++)
+        stream[nbits] = 0;
+
+    unsigned char packed[sizeof(stream) / 8];
+    for (i = 0; i < nbits / 8; i++)
+        packed[i] = pk_pack_byte_rl(stream + 8 * i);
+
+    log.valid = 0;
+    pk_g3ruh_deframer *g = pk_g3ruh_deframer_create(&log, log_callback);
+    for (i = 0; i < nbits; i += 29)
+        pk_g3ruh_deframer_process(g, stream + i, nbits - i < 29 ? nbits - i : 29);
+    pk_g3ruh_deframer_destroy(g);
+
+    if (log.valid != log.num)
+        log.result = FAIL;
+
+    log.valid = 0;
+    g = pk_g3ruh_deframer_create(&log, log_callback);
+    for (i = 0; i < nbits / 8; i += 11)
+        pk_g3ruh_deframer_process_packed(g, packed + i, nbits / 8 - i < 11 ? nbits / 8 - i : 11);
+    pk_g3ruh_deframer_destroy(g);
+
+    if (log.valid != log.num)
+        log.result = FAIL;
+
+    pk_ax25_framer_destroy(framer);
+
+    if (log.result == PASS)
+        printf("test_g3ruh_deframer passed.\n");
+    return log.result;
+}
+
 int main(int argc, char *argv[])
 {
     int result = PASS;
@@ -116,6 +416,10 @@ int main(int argc, char *argv[])
     // run all of the tests
     result += test_ax25_framer();
     result += test_ax25_framer_extra_bits();
+    result += test_ax25_deframer_packed();
+    result += test_ax25_framer_packed();
+    result += test_ax25_framer_restart();
+    result += test_g3ruh_deframer();
 
     printf("all framing tests finished.\n");
     return result;
@@ -24,6 +24,8 @@
 
 #include "common.h"
 
+#include <math.h>
+
 int test_modem_cfsk_1200()
 {
     unsigned int nbits = 256;
@@ -110,6 +112,447 @@ int test_modem_cfsk_9600()
     return PASS;
 }
 
+int test_modem_bfsk_sliding()
+{
+    unsigned int nbits = 512;
+    unsigned int samp_sym = 40;
+    unsigned int baud = 1200;
+    float mark_freq = 1200;
+    float space_freq = 2200;
+
+    srand(time(NULL));
+    unsigned char rbits[nbits];
+
+    unsigned int i;
+    for (i = 0; i < nbits; i++)
+        rbits[i] = rand() & 1;
+
+    pk_bfskmod *mod = pk_bfskmod_create(samp_sym, baud, mark_freq, space_freq);
+    pk_bfskdemod *demod = pk_bfskdemod_create(samp_sym, baud, mark_freq, space_freq);
+
+    size_t nsamps = samp_sym * nbits;
+    complex float *symbols = malloc(nsamps * sizeof(complex float));
+    pk_bfskmod_process(mod, symbols, rbits, nbits);
+
+    // add some noise so the decisions are not trivially separated
+    for (i = 0; i < nsamps; i++)
+        symbols[i] += 0.3f * ((float) rand() / RAND_MAX - 0.5f);
+
+    // feed in uneven chunks to exercise the state carried between calls
+    unsigned char *output = malloc(nsamps);
+    size_t nout = 0, offset = 0, chunk = 37;
+    while (offset < nsamps) {
+        size_t n = offset + chunk < nsamps ? chunk : nsamps - offset;
+        pk_bfskdemod_process(demod, symbols + offset, n);
+
+        size_t nitems = 0;
+        unsigned char *bits = pk_bfskdemod_read(demod, &nitems);
+        memcpy(output + nout, bits, nitems);
+        nout += nitems;
+        offset += n;
+    }
+
+    // reference decisions from the full matched filter over each window
+    complex float *window = calloc(samp_sym + nsamps, sizeof(complex float));
+    memcpy(window + samp_sym, symbols, nsamps * sizeof(complex float));
+
+    unsigned int timer = 0, diff = 0;
+    unsigned char past = 0;
+    size_t nref = 0;
+
+    int result = PASS;
+    for (i = 0; i < nsamps && result == PASS; i++) {
+        timer++;
+        unsigned char match = pk_bfskdemod_execute(demod, window + i + 1);
+
+        // a lone first sample has equal magnitude against both
+        // tones, so that decision only depends on the rounding
+        if (i == 0)
+            match = 0;
+
+        if (match != past) {
+            diff = 1;
+            past = match;
+            timer = samp_sym / 2 + samp_sym + 1;
+        }
+
+        if (timer >= 2*samp_sym) {
+            if (nref >= nout || output[nref] != (diff == 0))
+                result = FAIL;
+            nref++;
+            timer = samp_sym;
+            diff = 0;
+        }
+    }
+
+    if (nref != nout)
+        result = FAIL;
+
+    free(window);
+    free(output);
+    free(symbols);
+    pk_bfskmod_destroy(mod);
+    pk_bfskdemod_destroy(demod);
+
+    if (result == PASS)
+        printf("test_modem_bfsk_sliding passed.\n");
+    return result;
+}
+
+int test_modem_fsk96_chunked()
+{
+    unsigned int nbits = 512;
+    unsigned int samp_sym = 50;
+
+    srand(time(NULL));
+    unsigned char rbits[nbits];
+
+    unsigned int i;
+    for (i = 0; i < nbits; i++)
+        rbits[i] = rand() & 1;
+
+    // assume the first bit is a zero
+    rbits[0] = 0;
+
+    pk_fsk96mod *mod = pk_fsk96mod_create(samp_sym);
+    pk_fsk96demod *demod = pk_fsk96demod_create(samp_sym);
+
+    size_t nsamps = samp_sym * nbits;
+    float *symbols = malloc(nsamps * sizeof(float));
+    pk_fsk96mod_process(mod, symbols, rbits, nbits);
+
+    // feed in uneven chunks to exercise the state carried between calls
+    unsigned char *output = malloc(nsamps);
+    size_t nout = 0, offset = 0, chunk = 113;
+    while (offset < nsamps) {
+        size_t n = offset + chunk < nsamps ? chunk : nsamps - offset;
+        pk_fsk96demod_process(demod, symbols + offset, n);
+
+        size_t nitems = 0;
+        unsigned char *bits = pk_fsk96demod_read(demod, &nitems);
+        memcpy(output + nout, bits, nitems);
+        nout += nitems;
+        offset += n;
+    }
+
+    int result = nout >= nbits ? PASS : FAIL;
+    for (i = 0; i < nbits && result == PASS; i++) {
+        if (output[i] != rbits[i])
+            result = FAIL;
+    }
+
+    free(output);
+    free(symbols);
+    pk_fsk96mod_destroy(mod);
+    pk_fsk96demod_destroy(demod);
+
+    if (result == PASS)
+        printf("test_modem_fsk96_chunked passed.\n");
+    return result;
+}
+
+int test_modem_soft_output()
+{
+    unsigned int nbits = 256;
+    unsigned int samp_sym = 32;
+
+    srand(time(NULL));
+    unsigned char rbits[nbits];
+
+    unsigned int i;
+    for (i = 0; i < nbits; i++)
+        rbits[i] = rand() & 1;
+
+    pk_bfskmod *mod = pk_bfskmod_create(samp_sym, 1200, 1200, 2200);
+    pk_bfskdemod *demod = pk_bfskdemod_create(samp_sym, 1200, 1200, 2200);
+    pk_fsk96mod *mod96 = pk_fsk96mod_create(samp_sym);
+    pk_fsk96demod *demod96 = pk_fsk96demod_create(samp_sym);
+
+    complex float *symbols = malloc(samp_sym * nbits * sizeof(complex float));
+    float *symbols96 = malloc(samp_sym * nbits * sizeof(float));
+    pk_bfskmod_process(mod, symbols, rbits, nbits);
+    pk_fsk96mod_process(mod96, symbols96, rbits, nbits);
+
+    size_t nsoft = 0;
+    if (pk_bfskdemod_read_soft(demod, &nsoft) != NULL || nsoft != 0)
+        return FAIL;
+
+    pk_bfskdemod_set_soft(demod, 1);
+    pk_fsk96demod_set_soft(demod96, 1);
+    pk_bfskdemod_process(demod, symbols, samp_sym * nbits);
+    pk_fsk96demod_process(demod96, symbols96, samp_sym * nbits);
+
+    int result = PASS;
+
+    // on a clean signal the soft values agree with the hard bits and
+    // stay clear of zero within the -1..1 range
+    size_t nitems = 0;
+    unsigned char *bits = pk_bfskdemod_read(demod, &nitems);
+    float *soft = pk_bfskdemod_read_soft(demod, &nsoft);
+    if (nsoft != nitems)
+        result = FAIL;
+
+    for (i = 1; i < nitems && result == PASS; i++) {
+        if ((soft[i] > 0) != bits[i] || fabsf(soft[i]) < 0.25f || fabsf(soft[i]) > 1)
+            result = FAIL;
+    }
+
+    bits = pk_fsk96demod_read(demod96, &nitems);
+    soft = pk_fsk96demod_read_soft(demod96, &nsoft);
+    if (nsoft != nitems)
+        result = FAIL;
+
+    for (i = 1; i < nitems && result == PASS; i++) {
+        if ((soft[i] > 0) != bits[i] || fabsf(soft[i]) < 0.25f || fabsf(soft[i]) > 1)
+            result = FAIL;
+    }
+
+    free(symbols);
+    free(symbols96);
+    pk_bfskmod_destroy(mod);
+    pk_bfskdemod_destroy(demod);
+    pk_fsk96mod_destroy(mod96);
+    pk_fsk96demod_destroy(demod96);
+
+    if (result == PASS)
+        printf("test_modem_soft_output passed.\n");
+    return result;
+}
+
+int test_modem_gmsk()
+{
+    unsigned int nbits = 2000;
+    unsigned int samp_sym = 4;
+
+    srand(time(NULL));
+    unsigned char *rbits = malloc(nbits);
+
+    unsigned int i;
+    for (i = 0; i < nbits; i++)
+        rbits[i] = rand() & 1;
+
+    pk_gmskmod *mod = pk_gmskmod_create(samp_sym, 0.5f, 3);
+    pk_gmskdemod *demod = pk_gmskdemod_create(samp_sym, 0.01f);
+
+    size_t nsamps = samp_sym * nbits;
+    complex float *symbols = malloc(nsamps * sizeof(complex float));
+    pk_gmskmod_process(mod, symbols, rbits, nbits);
+
+    int result = PASS;
+
+    // constant envelope, and a slight carrier offset the
+    // differential detector should not care about
+    for (i = 0; i < nsamps; i++) {
+        if (!COMPARE_DELTA(cabsf(symbols[i]), 1.0f))
+            result = FAIL;
+        symbols[i] *= cexpf(I * 0.002f * i);
+    }
+
+    unsigned char *output = malloc(nbits + 16);
+    size_t nout = 0;
+    for (i = 0; i < nsamps; i += 100) {
+        size_t n = i + 100 < nsamps ? 100 : nsamps - i;
+        pk_gmskdemod_process(demod, symbols + i, n);
+
+        size_t nitems = 0;
+        unsigned char *bits = pk_gmskdemod_read(demod, &nitems);
+        memcpy(output + nout, bits, nitems);
+        nout += nitems;
+    }
+
+    // past the loop settling time the bits match at a fixed delay
+    int lag, found = 0;
+    for (lag = 0; lag <= 4 && !found && nout > 1000; lag++) {
+        found = 1;
+        size_t k;
+        for (k = 200; k < nout - 4 && k + lag < nbits; k++) {
+            if (output[k] != rbits[k + lag - 2]) {
+                found = 0;
+                break;
+            }
+        }
+    }
+
+    if (!found)
+        result = FAIL;
+
+    free(output);
+    free(symbols);
+    free(rbits);
+    pk_gmskmod_destroy(mod);
+    pk_gmskdemod_destroy(demod);
+
+    if (result == PASS)
+        printf("test_modem_gmsk passed.\n");
+    return result;
+}
+
+// true when arm a of the output matches arm b of the reference, possibly
+// inverted, at a fixed delay of whole symbols over the second half
+static int oqpsk_arm_match(const unsigned char *output, size_t nout, int a, const unsigned char *ref, size_t nref, int b)
+{
+    size_t lag;
+    int inv;
+    for (lag = 0; lag <= 4; lag++) {
+        for (inv = 0; inv <= 1; inv++) {
+            int match = 1;
+            size_t k;
+            for (k = nref / 4; 2 * k + a < nout && 2 * (k - lag) + b < nref; k++) {
+                if ((output[2 * k + a] ^ inv) != ref[2 * (k - lag) + b]) {
+                    match = 0;
+                    break;
+                }
+            }
+            if (match)
+                return 1;
+        }
+    }
+
+    return 0;
+}
+
+static int run_oqpsk(int offset, float delay)
+{
+    unsigned int nbits = 4000;
+    unsigned int samp_sym = 2;
+
+    unsigned char *rbits = malloc(nbits);
+
+    unsigned int i;
+    for (i = 0; i < nbits; i++)
+        rbits[i] = rand() & 1;
+
+    pk_oqpsk_mod *mod = pk_oqpsk_mod_create(samp_sym, offset);
+    pk_oqpsk_demod *demod = pk_oqpsk_demod_create(samp_sym, offset, 0.02f);
+
+    size_t nsamps = samp_sym * nbits / 2;
+    complex float *symbols = malloc(nsamps * sizeof(complex float));
+    pk_oqpsk_mod_process(mod, symbols, rbits, nbits);
+
+    // delay by a fraction of a sample, then apply a carrier
+    // phase and frequency offset
+    complex float past = 0;
+    for (i = 0; i < nsamps; i++) {
+        complex float x = symbols[i];
+        symbols[i] = (1.0f - delay) * x + delay * past;
+        past = x;
+    }
+
+    for (i = 0; i < nsamps; i++)
+        symbols[i] *= cexpf(I * (0.4f + 0.003f * i));
+
+    unsigned char *output = malloc(2 * nbits);
+    size_t nout = 0;
+    for (i = 0; i < nsamps; i += 63) {
+        size_t n = i + 63 < nsamps ? 63 : nsamps - i;
+        pk_oqpsk_demod_process(demod, symbols + i, n);
+
+        size_t nitems = 0;
+        unsigned char *bits = pk_oqpsk_demod_read(demod, &nitems);
+        memcpy(output + nout, bits, nitems);
+        nout += nitems;
+    }
+
+    int result = nout + 8 >= nbits ? PASS : FAIL;
+
+    // the interpolated symbols carry intersymbol interference
+    // that jitters the estimate
+    float tol = delay > 0 ? 0.0003f : 0.0001f;
+    if (fabsf(pk_oqpsk_demod_get_frequency(demod) - 0.003f) > tol)
+        result = FAIL;
+
+    // once locked the bits are right up to the carrier phase ambiguity,
+    // which can swap and invert the arms
+    if (!(oqpsk_arm_match(output, nout, 0, rbits, nbits, 0) && oqpsk_arm_match(output, nout, 1, rbits, nbits, 1))
+        && !(oqpsk_arm_match(output, nout, 0, rbits, nbits, 1) && oqpsk_arm_match(output, nout, 1, rbits, nbits, 0)))
+        result = FAIL;
+
+    free(output);
+    free(symbols);
+    free(rbits);
+    pk_oqpsk_mod_destroy(mod);
+    pk_oqpsk_demod_destroy(demod);
+
+    return result;
+}
+
+int test_modem_qpsk_costas()
+{
+    srand(time(NULL));
+
+    if (run_oqpsk(0, 0) != PASS)
+        return FAIL;
+
+    if (run_oqpsk(1, 0) != PASS)
+        return FAIL;
+
+    printf("test_modem_qpsk_costas passed.\n");
+    return PASS;
+}
+
+int test_modem_qpsk_timing()
+{
+    srand(time(NULL));
+
+    // symbol instants between the input samples
+    if (run_oqpsk(0, 0.5f) != PASS)
+        return FAIL;
+
+    if (run_oqpsk(1, 0.3f) != PASS)
+        return FAIL;
+
+    printf("test_modem_qpsk_timing passed.\n");
+    return PASS;
+}
+
+int test_modem_bfsk_qq()
+{
+    unsigned int nbits = 256;
+    unsigned int samp_sym = 32;
+
+    srand(time(NULL));
+    unsigned char rbits[nbits];
+
+    unsigned int i;
+    for (i = 0; i < nbits; i++)
+        rbits[i] = rand() & 1;
+
+    // assume the first bit is a zero
+    rbits[0] = 0;
+
+    pk_bfskmod *mod = pk_bfskmod_create(samp_sym, 1200, 1200, 2200);
+    pk_bfskdemod_qq *demod = pk_bfskdemod_qq_create(samp_sym, 1200, 1200, 2200);
+
+    // the real part of the modulator output as half scale audio
+    size_t nsamps = samp_sym * nbits;
+    complex float *symbols = malloc(nsamps * sizeof(complex float));
+    int16_t *audio = malloc(nsamps * sizeof(int16_t));
+    pk_bfskmod_process(mod, symbols, rbits, nbits);
+
+    for (i = 0; i < nsamps; i++)
+        audio[i] = (int16_t) lrintf(16384.0f * crealf(symbols[i]));
+
+    pk_bfskdemod_qq_process(demod, audio, nsamps);
+
+    size_t nitems = 0;
+    unsigned char *output = pk_bfskdemod_qq_read(demod, &nitems);
+
+    int result = nitems >= nbits - 1 ? PASS : FAIL;
+    for (i = 0; i < nbits - 1 && result == PASS; i++) {
+        if (output[i] != rbits[i])
+            result = FAIL;
+    }
+
+    free(audio);
+    free(symbols);
+    pk_bfskmod_destroy(mod);
+    pk_bfskdemod_qq_destroy(demod);
+
+    if (result == PASS)
+        printf("test_modem_bfsk_qq passed.\n");
+    return result;
+}
+
 int main(int argc, char *argv[])
 {
     int result = PASS;
@@ -117,6 +560,13 @@ int main(int argc, char *argv[])
     // run all of the tests
     result += test_modem_cfsk_1200();
     result += test_modem_cfsk_9600();
+    result += test_modem_bfsk_sliding();
+    result += test_modem_fsk96_chunked();
+    result += test_modem_soft_output();
+    result += test_modem_gmsk();
+    result += test_modem_qpsk_costas();
+    result += test_modem_qpsk_timing();
+    result += test_modem_bfsk_qq();
 
     printf("all modem tests finished.\n");
     return result;
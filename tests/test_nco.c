@@ -0,0 +1,146 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2015 Paul Uri David
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "common.h"
+
+#include <math.h>
+#include <complex.h>
+
+int test_nco_generate()
+{
+    float freq = 2.0f * M_PI * 0.0371f;
+    pk_nco *fine = pk_nco_create(freq, 1);
+    pk_nco *coarse = pk_nco_create(freq, 0);
+
+    // uneven lengths cover both the vector body and the scalar tail
+    complex float a[1000];
+    complex float b[1000];
+    pk_nco_generate(fine, a, 333);
+    pk_nco_generate(fine, a + 333, 667);
+    pk_nco_generate(coarse, b, 1000);
+
+    int result = PASS;
+
+    size_t i;
+    for (i = 0; i < 1000; i++) {
+        double phase = fmod((double) freq * i, 2.0 * M_PI);
+        complex float expect = cexp(I * phase);
+
+        if (cabsf(a[i] - expect) > 1e-4f || cabsf(b[i] - expect) > 4e-3f)
+            result = FAIL;
+    }
+
+    pk_nco_destroy(fine);
+    pk_nco_destroy(coarse);
+
+    if (result == PASS)
+        printf("test_nco_generate passed.\n");
+    return result;
+}
+
+int test_nco_mix()
+{
+    complex float input[257];
+    complex float up[257];
+    complex float down[257];
+
+    size_t i;
+    for (i = 0; i < 257; i++)
+        input[i] = cosf(0.1f * i) + I * sinf(0.37f * i);
+
+    // negative frequencies wrap around the phase accumulator
+    pk_nco *nco_up = pk_nco_create(-0.7f, 1);
+    pk_nco *nco_down = pk_nco_create(-0.7f, 1);
+
+    pk_nco_set_phase(nco_up, 1.0f);
+    pk_nco_set_phase(nco_down, 1.0f);
+
+    pk_nco_mix_up(nco_up, up, input, 257);
+    pk_nco_mix_down(nco_down, down, up, 257);
+
+    int result = PASS;
+    for (i = 0; i < 257; i++) {
+        if (cabsf(down[i] - input[i]) > 1e-4f)
+            result = FAIL;
+    }
+
+    if (!COMPARE_DELTA(pk_nco_get_frequency(nco_up), -0.7f))
+        result = FAIL;
+
+    pk_nco_destroy(nco_up);
+    pk_nco_destroy(nco_down);
+
+    if (result == PASS)
+        printf("test_nco_mix passed.\n");
+    return result;
+}
+
+int test_nco_adjust()
+{
+    pk_nco *nco = pk_nco_create(0.3f, 1);
+    float start = pk_nco_get_frequency(nco);
+
+    int result = PASS;
+
+    // corrections far below one step of the accumulator round away
+    // instead of each taking a step off
+    size_t i;
+    for (i = 0; i < 1000; i++) {
+        pk_nco_adjust_frequency(nco, -1e-10f);
+        pk_nco_adjust_frequency(nco, -1e-20f);
+    }
+
+    if (pk_nco_get_frequency(nco) != start)
+        result = FAIL;
+
+    // equal corrections either way cancel exactly, as a loop
+    // integrator dithering around its lock point does
+    for (i = 0; i < 1000; i++) {
+        float d = 1e-5f * (i % 7 + 1);
+        pk_nco_adjust_frequency(nco, d);
+        pk_nco_adjust_frequency(nco, -d);
+    }
+
+    if (pk_nco_get_frequency(nco) != start)
+        result = FAIL;
+
+    pk_nco_destroy(nco);
+
+    if (result == PASS)
+        printf("test_nco_adjust passed.\n");
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    int result = PASS;
+
+    // run all of the tests
+    result += test_nco_generate();
+    result += test_nco_mix();
+    result += test_nco_adjust();
+
+    printf("all nco tests finished.\n");
+    return result;
+}
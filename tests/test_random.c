@@ -54,12 +54,95 @@ int test_mult_scrambler()
     return PASS;
 }
 
+int test_scrambler_word()
+{
+    int result = PASS;
+
+    unsigned int n;
+    for (n = 2; n < 20; n++) {
+        pk_add_scrambler *add = pk_add_scrambler_create(n, 0x5a5a5 & ((1u << n) - 1));
+        pk_add_scrambler *add_word = pk_add_scrambler_create(n, 0x5a5a5 & ((1u << n) - 1));
+        pk_mult_scrambler *ms = pk_mult_scrambler_create(n, 0x1234);
+        pk_mult_scrambler *ms_word = pk_mult_scrambler_create(n, 0x1234);
+        pk_mult_descrambler *md = pk_mult_descrambler_create(n, 0x4321);
+        pk_mult_descrambler *md_word = pk_mult_descrambler_create(n, 0x4321);
+
+        size_t i;
+        for (i = 0; i < 100; i++) {
+            unsigned int num = (5 * i + n) % 65;
+            uint64_t input = (uint64_t) rand() << 42 ^ (uint64_t) rand() << 21 ^ rand();
+            if (num < 64)
+                input &= ((uint64_t) 1 << num) - 1;
+
+            uint64_t add_expect = 0, ms_expect = 0, md_expect = 0;
+
+            unsigned int j;
+            for (j = 0; j < num; j++) {
+                unsigned char bit = (input >> j) & 1;
+                add_expect |= (uint64_t) pk_add_scrambler_execute(add, bit) << j;
+                ms_expect |= (uint64_t) pk_mult_scrambler_execute(ms, bit) << j;
+                md_expect |= (uint64_t) pk_mult_descrambler_execute(md, bit) << j;
+            }
+
+            if (pk_add_scrambler_execute_word(add_word, input, num) != add_expect)
+                result = FAIL;
+            if (pk_mult_scrambler_execute_word(ms_word, input, num) != ms_expect)
+                result = FAIL;
+            if (pk_mult_descrambler_execute_word(md_word, input, num) != md_expect)
+                result = FAIL;
+        }
+
+        pk_add_scrambler_destroy(add);
+        pk_add_scrambler_destroy(add_word);
+        pk_mult_scrambler_destroy(ms);
+        pk_mult_scrambler_destroy(ms_word);
+        pk_mult_descrambler_destroy(md);
+        pk_mult_descrambler_destroy(md_word);
+    }
+
+    if (result == PASS)
+        printf("test_scrambler_word passed.\n");
+    return result;
+}
+
+int test_add_scrambler_jump()
+{
+    pk_add_scrambler *serial = pk_add_scrambler_create(17, 0x1ffff);
+    pk_add_scrambler *jump = pk_add_scrambler_create(17, 0x1ffff);
+
+    // descramble the second half of a block without the first
+    unsigned char expect[64];
+    size_t i;
+    for (i = 0; i < 5000; i++)
+        pk_add_scrambler_execute(serial, 0);
+    for (i = 0; i < 64; i++)
+        expect[i] = pk_add_scrambler_execute(serial, 0);
+
+    pk_add_scrambler_jump(jump, 5000);
+    uint64_t word = pk_add_scrambler_execute_word(jump, 0, 64);
+
+    int result = PASS;
+    for (i = 0; i < 64; i++) {
+        if (((word >> i) & 1) != expect[i])
+            result = FAIL;
+    }
+
+    pk_add_scrambler_destroy(serial);
+    pk_add_scrambler_destroy(jump);
+
+    if (result == PASS)
+        printf("test_add_scrambler_jump passed.\n");
+    return result;
+}
+
 int main(int argc, char *argv[])
 {
     int result = PASS;
 
     // run all of the tests
     result += test_mult_scrambler();
+    result += test_scrambler_word();
+    result += test_add_scrambler_jump();
 
     printf("all random tests finished.\n");
     return result;
@@ -45,12 +45,103 @@ int test_msequence_1()
     return PASS;
 }
 
+int test_lfsr_word()
+{
+    int result = PASS;
+
+    unsigned int n;
+    for (n = 2; n < 20; n++) {
+        uint32_t start = n % 3 ? 1 : 0xace1 & ((1u << n) - 1);
+        pk_lfsr *serial = pk_lfsr_create(n, start);
+        pk_lfsr *word = pk_lfsr_create(n, start);
+
+        // uneven word sizes, long enough to wrap the short sequences
+        size_t i;
+        for (i = 0; i < 200; i++) {
+            unsigned int num = (7 * i + n) % 65;
+
+            int period, word_period;
+            uint64_t expect = 0;
+
+            unsigned int j;
+            for (j = 0; j < num; j++)
+                expect |= (uint64_t) (pk_lfsr_execute(serial, &period) & 1) << j;
+
+            uint64_t bits = pk_lfsr_execute_word(word, num, &word_period);
+
+            if (bits != expect || (num > 0 && word_period != period))
+                result = FAIL;
+        }
+
+        pk_lfsr_destroy(serial);
+        pk_lfsr_destroy(word);
+    }
+
+    if (result == PASS)
+        printf("test_lfsr_word passed.\n");
+    return result;
+}
+
+int test_lfsr_jump()
+{
+    int result = PASS;
+
+    unsigned int n;
+    for (n = 2; n < 20; n++) {
+        uint32_t start = 0x2b3c5 & ((1u << n) - 1);
+        pk_lfsr *serial = pk_lfsr_create(n, start);
+        pk_lfsr *jump = pk_lfsr_create(n, start);
+
+        size_t i;
+        for (i = 0; i < 10; i++) {
+            size_t num = (i * i * 977 + n) % 3000;
+
+            int period, jump_period;
+            uint32_t state = 0;
+
+            size_t j;
+            for (j = 0; j < num; j++)
+                state = pk_lfsr_execute(serial, &period);
+
+            uint32_t jumped = pk_lfsr_jump(jump, num, &jump_period);
+
+            if (num > 0 && (jumped != state || jump_period != period))
+                result = FAIL;
+        }
+
+        // a long jump followed by serial steps lands where one
+        // longer jump does
+        pk_lfsr *far = pk_lfsr_create(n, start);
+        pk_lfsr *split = pk_lfsr_create(n, start);
+
+        int far_period, split_period;
+        uint32_t far_state = pk_lfsr_jump(far, ((size_t) 1 << 30) + 1234, &far_period);
+        uint32_t split_state = pk_lfsr_jump(split, (size_t) 1 << 30, &split_period);
+        for (i = 0; i < 1234; i++)
+            split_state = pk_lfsr_execute(split, &split_period);
+
+        if (far_state != split_state || far_period != split_period)
+            result = FAIL;
+
+        pk_lfsr_destroy(far);
+        pk_lfsr_destroy(split);
+        pk_lfsr_destroy(serial);
+        pk_lfsr_destroy(jump);
+    }
+
+    if (result == PASS)
+        printf("test_lfsr_jump passed.\n");
+    return result;
+}
+
 int main(int argc, char *argv[])
 {
     int result = PASS;
 
     // run all of the tests
     result += test_msequence_1();
+    result += test_lfsr_word();
+    result += test_lfsr_jump();
 
     printf("all sequences tests finished.\n");
     return result;